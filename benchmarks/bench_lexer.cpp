@@ -0,0 +1,108 @@
+// bench.h is not included, its Compare clashes with the AST Compare node
+#include "lexer/buffer.h"
+#include "lexer/lexer.h"
+#include "lexer/parallel.h"
+#include "utilities/pool.h"
+#include "utilities/stopwatch.h"
+
+#include "samples.h"
+
+#include <cstdio>
+#include <functional>
+#include <iostream>
+
+using namespace lython;
+
+// Source made of all the code samples repeated `copies` times
+String make_source(int copies) {
+    String code;
+
+#define APPEND(name) \
+    code += name();  \
+    code += "\n\n";
+
+    for (int i = 0; i < copies; i++) {
+        CODE_SAMPLES(APPEND)
+    }
+
+#undef APPEND
+    return code;
+}
+
+template <typename Lex>
+int lex_all(Lex& lexer) {
+    int count = 0;
+    while (lexer.next_token().type() != tok_eof) {
+        count += 1;
+    }
+    return count;
+}
+
+// Generic lexer: every character goes through the AbstractBuffer interface
+template <typename Buffer, typename... Args>
+int lex_generic(Args const&... args) {
+    Buffer          reader(args...);
+    AbstractBuffer& base = reader;
+    Lexer           lex(base);
+    return lex_all(lex);
+}
+
+// Lexer specialized for the concrete buffer type
+template <typename Buffer, typename... Args>
+int lex_typed(Args const&... args) {
+    Buffer              reader(args...);
+    BufferLexer<Buffer> lex(reader);
+    return lex_all(lex);
+}
+
+void run(String const& name, std::size_t size, std::function<int()> const& fun, int repeat = 20) {
+    double best   = 0;
+    int    tokens = 0;
+
+    for (int i = 0; i < repeat; i++) {
+        StopWatch<double, std::chrono::microseconds> time;
+        tokens         = fun();
+        double elapsed = time.stop();
+
+        if (i == 0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+
+    std::cout << fmt::format("{:>20} | {:10.3f} | {:10.3f} | {:10}\n",
+                             name,
+                             best / 1000.0,
+                             double(size) / best,
+                             tokens);
+}
+
+int main() {
+    String      code = make_source(1000);
+    String      name = "bench_lexer.ly";
+    std::size_t size = code.size();
+
+    FILE* file = fopen(name.c_str(), "w");
+    fwrite(code.data(), 1, code.size(), file);
+    fclose(file);
+
+    std::cout << fmt::format("{:>20} | {:>10} | {:>10} | {:>10}\n", "bench", "best (ms)", "MB/s", "tokens");
+    std::cout << "-------------------------------------------------------------\n";
+
+    // clang-format off
+    run("String Lexer",       size, [&]() { return lex_generic<StringBuffer>(code); });
+    run("String BufferLexer", size, [&]() { return lex_typed<StringBuffer>(code); });
+    run("File Lexer",         size, [&]() { return lex_generic<FileBuffer>(name); });
+    run("File BufferLexer",   size, [&]() { return lex_typed<FileBuffer>(name); });
+    run("Mapped Lexer",       size, [&]() { return lex_generic<MappedFileBuffer>(name); });
+    run("Mapped BufferLexer", size, [&]() { return lex_typed<MappedFileBuffer>(name); });
+
+    ThreadPool pool;
+    run("Mapped parallel",    size, [&]() {
+        MappedFileBuffer reader(name);
+        return int(parallel_lex(reader, pool).size()) - 1;
+    });
+    // clang-format on
+
+    std::remove(name.c_str());
+    return 0;
+}
@@ -0,0 +1,506 @@
+// bench.h is not included, its Compare clashes with the AST Compare node
+#include "ast/fields.h"
+#include "lexer/buffer.h"
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "sema/sema.h"
+#include "utilities/pool.h"
+#include "utilities/stopwatch.h"
+#include "utilities/strings.h"
+
+#include <sys/resource.h>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+
+using namespace lython;
+
+// Expression heavy source, every statement climbs through most precedence levels
+String make_expressions(int count) {
+    const char* operators[]   = {"+", "-", "*", "/", "//", "%", "**", "<<", ">>", "&", "|", "^"};
+    const char* comparisons[] = {"<", ">", "<=", ">=", "==", "!="};
+
+    String code;
+    for (int i = 0; i < count; i++) {
+        code += fmt::format("x{} = ", i);
+
+        for (int k = 0; k < 8; k++) {
+            code += fmt::format("a{} {} ", k, operators[(i + k) % 12]);
+        }
+        code += fmt::format("b {} c and not d or e is not f\n", comparisons[i % 6]);
+    }
+    return code;
+}
+
+// Synthetic programs
+// ------------------
+// The same settings always generate the same source
+struct ProgramConfig {
+    int      functions        = 2000;  // free functions
+    int      classes          = 400;   // classes, with 3 methods each
+    int      expression_depth = 4;     // nesting of the binary operations
+    int      comprehensions   = 2;     // nesting of the list comprehensions
+    int      matches          = 1;     // match statements per function
+    uint32_t seed             = 42;
+
+    // key=value, returns false if the key is unknown
+    bool set(String const& arg) {
+        auto eq = arg.find('=');
+        if (eq == String::npos) {
+            return false;
+        }
+
+        String key   = arg.substr(0, eq);
+        int    value = std::atoi(arg.c_str() + eq + 1);
+
+        // clang-format off
+        if      (key == "functions")        { functions        = value; }
+        else if (key == "classes")          { classes          = value; }
+        else if (key == "expression_depth") { expression_depth = value; }
+        else if (key == "comprehensions")   { comprehensions   = value; }
+        else if (key == "matches")          { matches          = value; }
+        else if (key == "seed")             { seed             = uint32_t(value); }
+        else                                { return false; }
+        // clang-format on
+        return true;
+    }
+};
+
+class ProgramGenerator {
+    public:
+    ProgramGenerator(ProgramConfig const& config):
+        config(config), state(config.seed == 0 ? 1 : config.seed) {}
+
+    String generate() {
+        // sema does not know the builtins
+        code += "def clamp(a: i32, b: i32) -> i32:\n";
+        code += "    if a > b:\n";
+        code += "        return b\n";
+        code += "    return a\n\n\n";
+
+        for (int i = 0; i < config.classes; i++) {
+            class_def(i);
+        }
+        for (int i = 0; i < config.functions; i++) {
+            function_def(i);
+        }
+        return code;
+    }
+
+    private:
+    // xorshift, the standard distributions are not the same on every platform
+    uint32_t next() {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    int pick(int n) { return int(next() % uint32_t(n)); }
+
+    String expression(int depth) {
+        const char* operators[] = {"+", "-", "*", "//", "%", "<<", ">>", "&", "|", "^"};
+
+        if (depth <= 0) {
+            switch (pick(3)) {
+            case 0: return "a";
+            case 1: return "b";
+            default: return fmtstr("{}", pick(1000) + 1);
+            }
+        }
+
+        String lhs = expression(depth - 1);
+        String rhs = expression(depth - 1);
+
+        switch (pick(6)) {
+        case 0: return fmtstr("({} {} {})", lhs, operators[pick(10)], rhs);
+        case 1: return fmtstr("clamp({}, {})", lhs, rhs);
+        case 2: return fmtstr("({} if ({}) > {} else {})", lhs, rhs, pick(100), lhs);
+        default: return fmtstr("{} {} {}", lhs, operators[pick(10)], rhs);
+        }
+    }
+
+    // sema does not type the targets of the comprehensions, they are not used
+    String comprehension(int depth, int level = 0) {
+        String var = fmtstr("v{}", level);
+
+        if (depth <= 1) {
+            return fmtstr("[{} for {} in [a, b, {}] if a > {}]", expression(1), var, pick(1000), pick(100));
+        }
+        return fmtstr("[{} for {} in [b, a]]", comprehension(depth - 1, level + 1), var);
+    }
+
+    void match(String const& indent) {
+        code += indent + "match a:\n";
+        code += indent + "    case 0:\n";
+        code += indent + "        x = " + expression(config.expression_depth) + "\n";
+        code += indent + "    case [1, y]:\n";
+        code += indent + "        x = y\n";
+        code += indent + "    case {1: y, **z}:\n";
+        code += indent + "        x = y\n";
+        code += indent + "    case y if a > b:\n";
+        code += indent + "        x = y\n";
+        code += indent + "    case _:\n";
+        code += indent + "        pass\n";
+    }
+
+    void body(String const& indent) {
+        code += indent + "x = " + expression(config.expression_depth) + "\n";
+
+        if (config.comprehensions > 0) {
+            code += indent + "y = " + comprehension(config.comprehensions) + "\n";
+        }
+        for (int k = 0; k < config.matches; k++) {
+            match(indent);
+        }
+        code += indent + "return x\n";
+    }
+
+    void function_def(int i) {
+        code += fmt::format("def f{}(a: i32, b: i32) -> i32:\n", i);
+        body("    ");
+        code += "\n\n";
+    }
+
+    void class_def(int i) {
+        code += fmt::format("class C{}:\n", i);
+        code += "    def __init__(self, a: i32):\n";
+        code += "        self.a = a\n\n";
+
+        for (int k = 0; k < 2; k++) {
+            code += fmt::format("    def m{}(self, a: i32, b: i32) -> i32:\n", k);
+            body("        ");
+            code += "\n";
+        }
+        code += "\n";
+    }
+
+    ProgramConfig const& config;
+    uint32_t             state;
+    String               code;
+};
+
+// Every statement is cut in the middle, the parser recovers from an error on each line
+String make_errors(String const& code) {
+    String broken;
+    for (String const& line: split('\n', code)) {
+        std::size_t cut = line.size() / 2;
+        while (cut < line.size() && line[cut] != ' ') {
+            cut += 1;
+        }
+        broken += line.substr(0, cut) + " +\n";
+    }
+    return broken;
+}
+
+// Inputs of the fuzzer, each file is also cut after each of its lines
+String load_inputs(String const& folder) {
+    String code;
+
+    std::error_code err;
+    for (auto const& entry: std::filesystem::directory_iterator(folder.c_str(), err)) {
+        if (entry.path().extension() != ".ly") {
+            continue;
+        }
+
+        String source = read_file(String(entry.path().string().c_str()));
+        for (std::size_t k = source.find('\n'); k != String::npos; k = source.find('\n', k + 1)) {
+            code += source.substr(0, k) + " +\n";
+        }
+        code += source + "\n";
+    }
+    return code;
+}
+
+int parse(String const& code) {
+    StringBuffer reader(code);
+    Lexer        lex(reader);
+    Parser       parser(lex);
+
+    Module* mod  = parser.parse_module();
+    int     size = int(mod->body.size());
+    delete mod;
+    return size;
+}
+
+int parse_errors(String const& code, bool throw_errors) {
+    StringBuffer reader(code);
+    Lexer        lex(reader);
+    Parser       parser(lex);
+    parser.set_throw_errors(throw_errors);
+
+    Module* mod = parser.parse_module();
+    delete mod;
+    return int(parser.get_errors().size());
+}
+
+// Pipeline stages
+// ---------------
+// Counts the nodes reachable from the module
+struct NodeCounter: NodeWalker<NodeCounter> {
+    std::size_t count = 0;
+
+    void node(Node* n) {
+        count += 1;
+        walk(n);
+    }
+};
+
+struct StageResult {
+    std::size_t items       = 0;  // tokens for the lexer, nodes otherwise
+    std::size_t arena_bytes = 0;  // the arenas are not seen by the allocation stats
+};
+
+StageResult lex_stage(String const& code) {
+    StringBuffer reader(code);
+    Lexer        lex(reader);
+
+    StageResult result;
+    while (lex.next_token().type() != tok_eof) {
+        result.items += 1;
+    }
+    return result;
+}
+
+// the function bodies are analysed on the pool when there is one
+StageResult parse_stage(String const& code, bool with_sema, ThreadPool* pool = nullptr) {
+    StringBuffer reader(code);
+    Lexer        lex(reader);
+    Parser       parser(lex);
+    Unique<Module> mod(parser.parse_module());
+
+    if (with_sema) {
+        SemanticAnalyser sema;
+        if (pool != nullptr) {
+            sema.exec_parallel(mod.get(), *pool);
+        } else {
+            sema.exec(mod.get(), 0);
+        }
+    }
+
+    NodeCounter counter;
+    for (StmtNode*& stmt: mod->body) {
+        counter(stmt);
+    }
+    return {counter.count, mod->arena->allocated()};
+}
+
+// Number of objects allocated for each type so far
+std::vector<int> allocation_counts() {
+    meta::StatTable const& stats = meta::stats();
+
+    std::vector<int> counts(stats.size());
+    for (std::size_t i = 0; i < counts.size(); i++) {
+        counts[i] = stats[i].size_alloc;
+    }
+    return counts;
+}
+
+// Bytes requested through the lython allocators
+std::size_t allocated_bytes(std::vector<int> const& before) {
+    meta::StatTable const& after = meta::stats();
+
+    std::size_t bytes = 0;
+    for (std::size_t i = 0; i < after.size(); i++) {
+        // the counters are int and wrap on long runs, their difference does not
+        uint32_t start = i < before.size() ? uint32_t(before[i]) : 0;
+        uint32_t count = uint32_t(after[i].size_alloc) - start;
+        bytes += std::size_t(count) * std::size_t(after[i].bytes);
+    }
+    return bytes;
+}
+
+// Start measuring the peak resident memory from the current one,
+// the high-water mark is reset through /proc (Linux 4.0+)
+bool reset_peak_rss() {
+#ifdef __GLIBC__
+    // the memory freed by the previous stages would hide the growth of the next one
+    malloc_trim(0);
+#endif
+
+    FILE* file = fopen("/proc/self/clear_refs", "w");
+    if (file == nullptr) {
+        return false;
+    }
+    bool ok = fputs("5", file) >= 0;
+    return (fclose(file) == 0) && ok;
+}
+
+// Peak resident memory since the last reset_peak_rss()
+double peak_rss_mb() {
+    FILE* file = fopen("/proc/self/status", "r");
+    if (file != nullptr) {
+        char line[256];
+        while (fgets(line, sizeof(line), file) != nullptr) {
+            if (std::strncmp(line, "VmHWM:", 6) == 0) {
+                fclose(file);
+                return double(std::atol(line + 6)) / 1024.0;  // kilobytes
+            }
+        }
+        fclose(file);
+    }
+
+    // the peak of the whole process, it cannot be reset
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return double(usage.ru_maxrss) / 1024.0;  // kilobytes on linux
+}
+
+void run_stage(String const&                       name,
+               String const&                       code,
+               std::size_t                         tokens,
+               std::function<StageResult()> const& fun,
+               int                                 repeat = 5) {
+    // allocations and the peak memory are measured on a run of their own
+    reset_peak_rss();
+    std::vector<int> before = allocation_counts();
+    StageResult      result = fun();
+    std::size_t      bytes  = allocated_bytes(before) + result.arena_bytes;
+    double           peak   = peak_rss_mb();
+
+    double best = 0;
+    for (int i = 0; i < repeat; i++) {
+        StopWatch<double, std::chrono::microseconds> time;
+        fun();
+        double elapsed = time.stop();
+
+        if (i == 0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+
+    // the lexer does not build nodes
+    double nodes = name == "Lexer" ? 0 : double(result.items) / best;
+
+    std::cout << fmt::format("{:>22} | {:10.3f} | {:10.3f} | {:10.3f} | {:10.3f} | {:10.3f} | {:14.3f}\n",
+                             name,
+                             best / 1000.0,
+                             double(code.size()) / best,
+                             double(tokens) / best,
+                             nodes,
+                             double(bytes) / (1024.0 * 1024.0),
+                             peak);
+}
+
+// operator lookup the parser did before tokens carried their operator id
+int lookup_by_name(Array<Token> const& tokens) {
+    Dict<String, OpConfig> const& confs = default_precedence();
+
+    int count = 0;
+    for (Token const& tok: tokens) {
+        auto result = confs.find(String(tok.operator_name()));
+        count += result != confs.end() && result->second.precedence > 0;
+    }
+    return count;
+}
+
+int lookup_by_id(Array<Token> const& tokens) {
+    int count = 0;
+    for (Token const& tok: tokens) {
+        count += operator_table[tok.operator_id()].config.precedence > 0;
+    }
+    return count;
+}
+
+void run(String const& name, std::size_t size, std::function<int()> const& fun, int repeat = 10) {
+    double best  = 0;
+    int    items = 0;
+
+    for (int i = 0; i < repeat; i++) {
+        StopWatch<double, std::chrono::microseconds> time;
+        items          = fun();
+        double elapsed = time.stop();
+
+        if (i == 0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+
+    std::cout << fmt::format(
+        "{:>20} | {:10.3f} | {:10.3f} | {:10}\n", name, best / 1000.0, double(size) / best, items);
+}
+
+// bench_parser [fuzzer inputs folder] [key=value...]
+// the keys are the fields of ProgramConfig
+int main(int argc, const char* argv[]) {
+    // the parser traces every rule it enters and logs every syntax error
+    set_log_level(LogLevel::Trace, false);
+    set_log_level(LogLevel::Debug, false);
+    set_log_level(LogLevel::Info, false);
+    set_log_level(LogLevel::Warn, false);
+    set_log_level(LogLevel::Error, false);
+
+    ProgramConfig config;
+    String        inputs = "hardening/fuzzing/in";
+
+    for (int i = 1; i < argc; i++) {
+        if (!config.set(argv[i])) {
+            inputs = argv[i];
+        }
+    }
+
+    String      code = make_expressions(20000);
+    std::size_t size = code.size();
+
+    StringBuffer reader(code);
+    Lexer        lex(reader);
+    Array<Token> tokens = lex.extract_token();
+
+    String errors = make_errors(code) + load_inputs(inputs);
+
+    std::cout << fmt::format("{:>20} | {:>10} | {:>10} | {:>10}\n", "bench", "best (ms)", "MB/s", "items");
+    std::cout << "-------------------------------------------------------------\n";
+
+    // clang-format off
+    run("Operator by name", size, [&]() { return lookup_by_name(tokens); });
+    run("Operator by id",   size, [&]() { return lookup_by_id(tokens); });
+    run("Parse expressions", size, [&]() { return parse(code); });
+    run("Errors throw",  errors.size(), [&]() { return parse_errors(errors, true); });
+    run("Errors return", errors.size(), [&]() { return parse_errors(errors, false); });
+    // clang-format on
+
+    ThreadPool  pool;
+    String      program = ProgramGenerator(config).generate();
+    std::size_t count   = lex_stage(program).items;
+
+    std::cout << fmt::format("\nSynthetic program: {} functions, {} classes, {:.3f} MB, {} tokens\n\n",
+                             config.functions,
+                             config.classes,
+                             double(program.size()) / (1024.0 * 1024.0),
+                             count);
+
+    // the peak is the resident memory of the process while the stage runs,
+    // the program and its tokens included
+    if (!reset_peak_rss()) {
+        std::cout << "/proc/self/clear_refs is not writable, the peak is the one of the whole process\n\n";
+    }
+
+    std::cout << fmt::format("{:>22} | {:>10} | {:>10} | {:>10} | {:>10} | {:>10} | {:>14}\n",
+                             "stage",
+                             "best (ms)",
+                             "MB/s",
+                             "Mtok/s",
+                             "Mnode/s",
+                             "alloc (MB)",
+                             "peak (MB)");
+    std::cout << "------------------------------------------------------------------------------"
+                 "--------------------------\n";
+
+    // clang-format off
+    run_stage("Lexer",                 program, count, [&]() { return lex_stage(program); });
+    run_stage("Lexer + Parser",        program, count, [&]() { return parse_stage(program, false); });
+    run_stage("Lexer + Parser + Sema", program, count, [&]() { return parse_stage(program, true); });
+    run_stage("Parser + Sema (pool)",  program, count, [&]() { return parse_stage(program, true, &pool); });
+    // clang-format on
+
+    return 0;
+}
@@ -0,0 +1,651 @@
+#pragma once
+
+#include "ast/nodes.h"
+
+#include <type_traits>
+
+namespace lython {
+
+// Fields of the nodes, as the parser produces them
+// ------------------------------------------------
+// The archive is called on every field in source order, it can read them (writer, line shifts)
+// or overwrite them (reader). What sema resolves is not listed.
+// Archives define `static constexpr bool loading` and handle the location of a node
+// through ar(CommonAttributes&)
+
+
+template <typename Ar>
+void fields(Ar& ar, CommonAttributes& n) {
+    ar(n.start);
+    ar(n.end);
+}
+
+template <typename Ar>
+void fields(Ar& ar, Comprehension& n) {
+    ar(n.target);
+    ar(n.iter);
+    ar(n.ifs);
+
+    bool async = n.is_async;
+    ar(async);
+    n.is_async = async;
+}
+
+template <typename Ar>
+void fields(Ar& ar, ExceptHandler& n) {
+    ar(static_cast<CommonAttributes&>(n));
+    ar(n.type);
+    ar(n.name);
+    ar(n.body);
+    ar(n.comment);
+}
+
+template <typename Ar>
+void fields(Ar& ar, Arg& n) {
+    ar(static_cast<CommonAttributes&>(n));
+    ar(n.arg);
+    ar(n.annotation);
+    ar(n.type_comment);
+}
+
+template <typename Ar>
+void fields(Ar& ar, Arguments& n) {
+    ar(n.posonlyargs);
+    ar(n.args);
+    ar(n.vararg);
+    ar(n.kwonlyargs);
+    ar(n.kw_defaults);
+    ar(n.kwarg);
+    ar(n.defaults);
+}
+
+template <typename Ar>
+void fields(Ar& ar, Keyword& n) {
+    ar(static_cast<CommonAttributes&>(n));
+    ar(n.arg);
+    ar(n.value);
+}
+
+template <typename Ar>
+void fields(Ar& ar, Alias& n) {
+    ar(n.name);
+    ar(n.asname);
+}
+
+template <typename Ar>
+void fields(Ar& ar, WithItem& n) {
+    ar(n.context_expr);
+    ar(n.optional_vars);
+}
+
+template <typename Ar>
+void fields(Ar& ar, MatchCase& n) {
+    ar(n.pattern);
+    ar(n.guard);
+    ar(n.body);
+    ar(n.comment);
+}
+
+template <typename Ar>
+void fields(Ar& ar, Decorator& n) {
+    ar(n.expr);
+    ar(n.comment);
+}
+
+template <typename Ar>
+void fields(Ar& ar, Docstring& n) {
+    ar(n.docstring);
+    ar(n.comment);
+}
+
+// Expressions
+template <typename Ar>
+void fields(Ar& ar, BoolOp& n) {
+    ar(n.op);
+    ar(n.values);
+    ar(n.opcount);
+}
+
+template <typename Ar>
+void fields(Ar& ar, NamedExpr& n) {
+    ar(n.target);
+    ar(n.value);
+}
+
+template <typename Ar>
+void fields(Ar& ar, BinOp& n) {
+    ar(n.left);
+    ar(n.op);
+    ar(n.right);
+}
+
+template <typename Ar>
+void fields(Ar& ar, UnaryOp& n) {
+    ar(n.op);
+    ar(n.operand);
+}
+
+template <typename Ar>
+void fields(Ar& ar, Lambda& n) {
+    ar(n.args);
+    ar(n.body);
+}
+
+template <typename Ar>
+void fields(Ar& ar, IfExp& n) {
+    ar(n.test);
+    ar(n.body);
+    ar(n.orelse);
+}
+
+template <typename Ar>
+void fields(Ar& ar, DictExpr& n) {
+    ar(n.keys);
+    ar(n.values);
+}
+
+template <typename Ar>
+void fields(Ar& ar, SetExpr& n) {
+    ar(n.elts);
+}
+
+template <typename Ar>
+void fields(Ar& ar, ListComp& n) {
+    ar(n.elt);
+    ar(n.generators);
+}
+
+template <typename Ar>
+void fields(Ar& ar, GeneratorExp& n) {
+    ar(n.elt);
+    ar(n.generators);
+}
+
+template <typename Ar>
+void fields(Ar& ar, SetComp& n) {
+    ar(n.elt);
+    ar(n.generators);
+}
+
+template <typename Ar>
+void fields(Ar& ar, DictComp& n) {
+    ar(n.key);
+    ar(n.value);
+    ar(n.generators);
+}
+
+template <typename Ar>
+void fields(Ar& ar, Await& n) {
+    ar(n.value);
+}
+
+template <typename Ar>
+void fields(Ar& ar, Yield& n) {
+    ar(n.value);
+}
+
+template <typename Ar>
+void fields(Ar& ar, YieldFrom& n) {
+    ar(n.value);
+}
+
+template <typename Ar>
+void fields(Ar& ar, Compare& n) {
+    ar(n.left);
+    ar(n.ops);
+    ar(n.comparators);
+}
+
+template <typename Ar>
+void fields(Ar& ar, Call& n) {
+    ar(n.func);
+    ar(n.args);
+    ar(n.keywords);
+}
+
+template <typename Ar>
+void fields(Ar& ar, JoinedStr& n) {
+    ar(n.values);
+}
+
+template <typename Ar>
+void fields(Ar& ar, FormattedValue& n) {
+    ar(n.value);
+    ar(n.conversion);
+    ar(n.format_spec.values);
+}
+
+template <typename Ar>
+void fields(Ar& ar, Constant& n) {
+    ar(n.value);
+    ar(n.kind);
+}
+
+template <typename Ar>
+void fields(Ar& ar, Attribute& n) {
+    ar(n.value);
+    ar(n.attr);
+    ar(n.ctx);
+}
+
+template <typename Ar>
+void fields(Ar& ar, Subscript& n) {
+    ar(n.value);
+    ar(n.slice);
+    ar(n.ctx);
+}
+
+template <typename Ar>
+void fields(Ar& ar, Starred& n) {
+    ar(n.value);
+    ar(n.ctx);
+}
+
+template <typename Ar>
+void fields(Ar& ar, Name& n) {
+    ar(n.id);
+    ar(n.ctx);
+}
+
+template <typename Ar>
+void fields(Ar& ar, ListExpr& n) {
+    ar(n.elts);
+    ar(n.ctx);
+}
+
+template <typename Ar>
+void fields(Ar& ar, TupleExpr& n) {
+    ar(n.elts);
+    ar(n.ctx);
+}
+
+template <typename Ar>
+void fields(Ar& ar, Slice& n) {
+    ar(n.lower);
+    ar(n.upper);
+    ar(n.step);
+}
+
+template <typename Ar>
+void fields(Ar& ar, DictType& n) {
+    ar(n.key);
+    ar(n.value);
+}
+
+template <typename Ar>
+void fields(Ar& ar, ArrayType& n) {
+    ar(n.value);
+}
+
+template <typename Ar>
+void fields(Ar& ar, TupleType& n) {
+    ar(n.types);
+}
+
+template <typename Ar>
+void fields(Ar& ar, Arrow& n) {
+    ar(n.names);
+    ar(n.args);
+    ar(n.returns);
+}
+
+// the class is resolved by sema
+template <typename Ar>
+void fields(Ar&, ClassType&) {}
+
+template <typename Ar>
+void fields(Ar& ar, SetType& n) {
+    ar(n.value);
+}
+
+// native functions are resolved by sema
+template <typename Ar>
+void fields(Ar& ar, BuiltinType& n) {
+    ar(n.name);
+}
+
+template <typename Ar>
+void fields(Ar& ar, Comment& n) {
+    ar(n.comment);
+}
+
+// Modules
+template <typename Ar>
+void fields(Ar& ar, Module& n) {
+    ar(n.body);
+    ar(n.docstring);
+}
+
+template <typename Ar>
+void fields(Ar& ar, Interactive& n) {
+    ar(n.body);
+}
+
+template <typename Ar>
+void fields(Ar& ar, Expression& n) {
+    ar(n.body);
+}
+
+template <typename Ar>
+void fields(Ar& ar, FunctionType& n) {
+    ar(n.argtypes);
+    ar(n.returns);
+}
+
+// Statements
+template <typename Ar>
+void fields(Ar& ar, InvalidStatement& n) {
+    ar(n.tokens);
+
+    // the tokens point inside the file being read
+    if (Ar::loading) {
+        n.set_tokens(Array<Token>(n.tokens));
+    }
+}
+
+template <typename Ar>
+void fields(Ar& ar, FunctionDef& n) {
+    ar(n.name);
+    ar(n.args);
+    ar(n.body);
+    ar(n.decorator_list);
+    ar(n.returns);
+    ar(n.type_comment);
+    ar(n.docstring);
+
+    bool async = n.async;
+    ar(async);
+    n.async = async;
+}
+
+template <typename Ar>
+void fields(Ar& ar, ClassDef& n) {
+    ar(n.name);
+    ar(n.bases);
+    ar(n.keywords);
+    ar(n.body);
+    ar(n.decorator_list);
+    ar(n.docstring);
+}
+
+template <typename Ar>
+void fields(Ar& ar, Return& n) {
+    ar(n.value);
+}
+
+template <typename Ar>
+void fields(Ar& ar, Delete& n) {
+    ar(n.targets);
+}
+
+template <typename Ar>
+void fields(Ar& ar, Assign& n) {
+    ar(n.targets);
+    ar(n.value);
+    ar(n.type_comment);
+}
+
+template <typename Ar>
+void fields(Ar& ar, AugAssign& n) {
+    ar(n.target);
+    ar(n.op);
+    ar(n.value);
+}
+
+template <typename Ar>
+void fields(Ar& ar, AnnAssign& n) {
+    ar(n.target);
+    ar(n.annotation);
+    ar(n.value);
+    ar(n.simple);
+}
+
+template <typename Ar>
+void fields(Ar& ar, For& n) {
+    ar(n.target);
+    ar(n.iter);
+    ar(n.body);
+    ar(n.orelse);
+    ar(n.type_comment);
+    ar(n.async);
+    ar(n.else_comment);
+}
+
+template <typename Ar>
+void fields(Ar& ar, While& n) {
+    ar(n.test);
+    ar(n.body);
+    ar(n.orelse);
+    ar(n.else_comment);
+}
+
+template <typename Ar>
+void fields(Ar& ar, If& n) {
+    ar(n.test);
+    ar(n.body);
+    ar(n.orelse);
+    ar(n.tests);
+    ar(n.bodies);
+    ar(n.tests_comment);
+    ar(n.else_comment);
+}
+
+template <typename Ar>
+void fields(Ar& ar, With& n) {
+    ar(n.items);
+    ar(n.body);
+    ar(n.type_comment);
+    ar(n.async);
+}
+
+template <typename Ar>
+void fields(Ar& ar, Raise& n) {
+    ar(n.exc);
+    ar(n.cause);
+}
+
+template <typename Ar>
+void fields(Ar& ar, Try& n) {
+    ar(n.body);
+    ar(n.handlers);
+    ar(n.orelse);
+    ar(n.finalbody);
+    ar(n.else_comment);
+    ar(n.finally_comment);
+}
+
+template <typename Ar>
+void fields(Ar& ar, Assert& n) {
+    ar(n.test);
+    ar(n.msg);
+}
+
+template <typename Ar>
+void fields(Ar& ar, Import& n) {
+    ar(n.names);
+}
+
+template <typename Ar>
+void fields(Ar& ar, ImportFrom& n) {
+    ar(n.module);
+    ar(n.names);
+    ar(n.level);
+}
+
+template <typename Ar>
+void fields(Ar& ar, Global& n) {
+    ar(n.names);
+}
+
+template <typename Ar>
+void fields(Ar& ar, Nonlocal& n) {
+    ar(n.names);
+}
+
+template <typename Ar>
+void fields(Ar& ar, Expr& n) {
+    ar(n.value);
+}
+
+template <typename Ar>
+void fields(Ar&, Pass&) {}
+
+template <typename Ar>
+void fields(Ar&, Break&) {}
+
+template <typename Ar>
+void fields(Ar&, Continue&) {}
+
+template <typename Ar>
+void fields(Ar& ar, Match& n) {
+    ar(n.subject);
+    ar(n.cases);
+}
+
+template <typename Ar>
+void fields(Ar& ar, Inline& n) {
+    ar(n.body);
+}
+
+// Patterns
+template <typename Ar>
+void fields(Ar& ar, MatchValue& n) {
+    ar(n.value);
+}
+
+template <typename Ar>
+void fields(Ar& ar, MatchSingleton& n) {
+    ar(n.value);
+}
+
+template <typename Ar>
+void fields(Ar& ar, MatchSequence& n) {
+    ar(n.patterns);
+}
+
+template <typename Ar>
+void fields(Ar& ar, MatchMapping& n) {
+    ar(n.keys);
+    ar(n.patterns);
+    ar(n.rest);
+}
+
+template <typename Ar>
+void fields(Ar& ar, MatchClass& n) {
+    ar(n.cls);
+    ar(n.patterns);
+    ar(n.kwd_attrs);
+    ar(n.kwd_patterns);
+}
+
+template <typename Ar>
+void fields(Ar& ar, MatchStar& n) {
+    ar(n.name);
+}
+
+template <typename Ar>
+void fields(Ar& ar, MatchAs& n) {
+    ar(n.pattern);
+    ar(n.name);
+}
+
+template <typename Ar>
+void fields(Ar& ar, MatchOr& n) {
+    ar(n.patterns);
+}
+
+// Fields every node of a family has
+template <typename Ar>
+void base_fields(Ar& ar, Node* n) {
+    switch (n->family()) {
+    case NodeFamily::Statement: {
+        StmtNode* stmt = static_cast<StmtNode*>(n);
+        ar(static_cast<CommonAttributes&>(*stmt));
+        ar(stmt->comment);
+        return;
+    }
+    case NodeFamily::Expression:
+        ar(static_cast<CommonAttributes&>(*static_cast<ExprNode*>(n)));
+        return;
+    case NodeFamily::Pattern:
+        ar(static_cast<CommonAttributes&>(*static_cast<Pattern*>(n)));
+        return;
+    case NodeFamily::Module: return;
+    }
+}
+
+// Fields of a node, its family's first
+template <typename Ar>
+void node_fields(Ar& ar, Node* n) {
+    base_fields(ar, n);
+
+    // clang-format off
+    switch (n->kind) {
+        #define X(name, _)
+        #define SECTION(_)
+        #define NODE(name, _)\
+            case NodeKind::name: fields(ar, *reinterpret_cast<name*>(n)); return;
+
+        NODEKIND_ENUM(X, SECTION, NODE, NODE, NODE, NODE)
+
+        #undef X
+        #undef SECTION
+        #undef NODE
+
+        default: return;
+    }
+    // clang-format on
+}
+
+// Walks the nodes reachable from a node, their fields in source order.
+// Walkers derive from it and hide the hooks they need,
+// node() goes through the fields of the node by default
+template <typename Walker>
+struct NodeWalker {
+    static constexpr bool loading = false;
+
+    void node(Node* n) { walk(n); }
+    void location(CommonAttributes&) {}
+    void token(Token&) {}
+
+    void walk(Node* n) { node_fields(*this, n); }
+
+    template <typename T>
+    void operator()(T& value) {
+        if constexpr (!std::is_arithmetic_v<T> && !std::is_enum_v<T>) {
+            fields(*this, value);
+        }
+    }
+
+    template <typename T>
+    void operator()(T*& n) {
+        if (n != nullptr) {
+            walker().node(n);
+        }
+    }
+
+    template <typename T>
+    void operator()(Optional<T>& value) {
+        if (value.has_value()) {
+            (*this)(value.value());
+        }
+    }
+
+    template <typename T>
+    void operator()(Array<T>& values) {
+        for (T& value: values) {
+            (*this)(value);
+        }
+    }
+
+    void operator()(String&) {}
+    void operator()(StringRef&) {}
+    void operator()(ConstantValue&) {}
+    void operator()(CommonAttributes& loc) { walker().location(loc); }
+    void operator()(Token& tok) { walker().token(tok); }
+
+    private:
+    Walker& walker() { return *static_cast<Walker*>(this); }
+};
+
+}  // namespace lython
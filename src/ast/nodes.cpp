@@ -225,4 +225,31 @@ bool Arrow::set_arg_type(int i, ExprNode* arg_type) {
 }
 
 // ------------------------------------------
+// Copy the tokens and their text, the copies point inside text
+void own_tokens(Array<Token> const& toks, Array<Token>& tokens, String& text) {
+    std::size_t size = 0;
+    for (Token const& tok: toks) {
+        size += tok.identifier().size();
+    }
+
+    // reserve upfront so the views stay valid
+    text.clear();
+    text.reserve(size);
+    tokens.clear();
+    tokens.reserve(toks.size());
+
+    for (Token const& tok: toks) {
+        StringView  view = tok.identifier();
+        const char* data = text.data() + text.size();
+
+        text.append(view.data(), view.size());
+        tokens.emplace_back(
+            tok.type(), tok.line(), tok.col(), StringView(data, view.size()), tok.operator_id());
+    }
+}
+
+void InvalidStatement::set_tokens(Array<Token> const& toks) { own_tokens(toks, tokens, text); }
+
+void LazyBody::set_tokens(Array<Token> const& toks) { own_tokens(toks, tokens, text); }
+
 }  // namespace lython
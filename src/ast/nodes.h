@@ -1,6 +1,7 @@
 #ifndef LYTHON_SEXPR_HEADER
 #define LYTHON_SEXPR_HEADER
 
+#include <algorithm>
 #include <memory>
 
 #include "ast/nodekind.h"
@@ -26,12 +27,47 @@ enum class NodeFamily : int8_t
     Pattern,
 };
 
+// Source span of a node, both ends are packed in 32 bits as (line + 1, column)
+// 0 is an unknown position. Every statement, expression and pattern carries one
+// so it is kept to 8 bytes, lines past max_line are unknown and columns are clamped
+//
 // col_offset is the byte offset in the utf8 string the parser uses
 struct CommonAttributes {
-    int           lineno     = -2;
-    int           col_offset = -2;
-    Optional<int> end_lineno;
-    Optional<int> end_col_offset;
+    static constexpr int    column_bits = 12;
+    static constexpr uint32 column_mask = (1u << column_bits) - 1;
+    static constexpr int    max_column  = int(column_mask) - 1;  // column_mask is no column
+    static constexpr int    max_line    = int((~uint32(0) >> column_bits) - 1);
+
+    uint32 start = 0;
+    uint32 end   = 0;
+
+    int lineno() const { return start == 0 ? -2 : int(start >> column_bits) - 1; }
+    int col_offset() const { return start == 0 ? -2 : column(start).value(); }
+
+    Optional<int> end_lineno() const {
+        return end == 0 ? none<int>() : some(int(end >> column_bits) - 1);
+    }
+    Optional<int> end_col_offset() const { return end == 0 ? none<int>() : column(end); }
+
+    void set_start(int line, int col) { start = pack(line, col); }
+    void set_end(int line, Optional<int> col = none<int>()) { end = pack(line, col); }
+
+    static uint32 pack(int line, Optional<int> col) {
+        if (line < 0 || line > max_line) {
+            return 0;
+        }
+
+        uint32 packed = column_mask;
+        if (col.has_value()) {
+            packed = uint32(std::min(std::max(col.value(), 0), max_column));
+        }
+        return (uint32(line + 1) << column_bits) | packed;
+    }
+
+    static Optional<int> column(uint32 pos) {
+        uint32 col = pos & column_mask;
+        return col == column_mask ? none<int>() : some(int(col));
+    }
 };
 
 template <typename T>
@@ -88,8 +124,8 @@ struct StmtNode: public CommonAttributes, public Node {
     Comment* comment = nullptr;
 
     bool is_one_line() const {
-        if (end_lineno.has_value()) {
-            return lineno == end_lineno.value();
+        if (end_lineno().has_value()) {
+            return lineno() == end_lineno().value();
         }
         return true;
     }
@@ -632,6 +668,20 @@ struct Module: public ModNode {
     Optional<String> docstring;
 
     Module(): ModNode(NodeKind::Module) {}
+
+    // Allocate the nodes of the module from a single region
+    // released all at once when the module is destroyed
+    void enable_arena() {
+        if (arena == nullptr) {
+            arena = std::make_unique<Arena>();
+            set_arena(arena.get());
+        }
+    }
+
+    Unique<Arena> arena;
+
+    // arenas of the nodes parsed by the workers of a parallel parse
+    Array<Unique<Arena>> arenas;
 };
 
 struct Interactive: public ModNode {
@@ -662,8 +712,11 @@ struct InvalidStatement: public StmtNode {
     // struct ParsingError* error = nullptr;
 
     Array<Token> tokens;
+    String       text;  // owns the text of the tokens, the source might not outlive the module
 
     InvalidStatement(): StmtNode(NodeKind::InvalidStatement) {}
+
+    void set_tokens(Array<Token> const& toks);
 };
 
 struct Inline: public StmtNode {
@@ -687,6 +740,38 @@ struct Docstring {
     Docstring(String const& doc, Comment* com = nullptr): docstring(doc), comment(com) {}
 };
 
+// Tokens of a function body skipped by a lazy parser.
+// The text of the tokens is owned so the body can be parsed after the source buffer is gone,
+// copies rebase the tokens on their own text
+struct LazyBody {
+    Array<Token> tokens;
+    String       text;
+    bool         async = false;
+
+    LazyBody() = default;
+    LazyBody(LazyBody const& body): async(body.async) { set_tokens(body.tokens); }
+
+    LazyBody& operator=(LazyBody const& body) {
+        if (this != &body) {
+            set_tokens(body.tokens);
+            async = body.async;
+        }
+        return *this;
+    }
+
+    bool pending() const { return !tokens.empty(); }
+
+    // the body had syntax errors when it was parsed, the text is kept for their tokens
+    bool invalid() const { return tokens.empty() && !text.empty(); }
+
+    void clear() {
+        tokens.clear();
+        text.clear();
+    }
+
+    void set_tokens(Array<Token> const& toks);
+};
+
 struct FunctionDef: public StmtNode {
     Identifier          name;
     Arguments           args;
@@ -696,6 +781,9 @@ struct FunctionDef: public StmtNode {
     String              type_comment;
     Optional<Docstring> docstring;
 
+    // set when the body was skipped, see materialize()
+    LazyBody lazy;
+
     bool async : 1;
     // SEMA
     bool          generator : 1;
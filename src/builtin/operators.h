@@ -1,35 +1,24 @@
 #pragma once
 
 #include "ast/nodes.h"
+#include "sema/builtin.h"
 
 namespace lython {
 
-// Binary
-Dict<StringRef, BinOp::NativeBinaryOp> build_native_binary_operators();
+// Native implementations of the operators on builtin types
+// returns null if the operation is not supported for the operand types.
+//
+// The implementations are stored in dense tables indexed by operator and operand types,
+// the tables are built at compile time
+BinOp::NativeBinaryOp
+get_native_binary_operation(BinaryOperator op, BuiltinTypeId lhs, BuiltinTypeId rhs);
 
-Dict<StringRef, BinOp::NativeBinaryOp> const& native_binary_operators();
+BoolOp::NativeBoolyOp
+get_native_bool_operation(BoolOperator op, BuiltinTypeId lhs, BuiltinTypeId rhs);
 
-BinOp::NativeBinaryOp get_native_binary_operation(StringRef signature);
+UnaryOp::NativeUnaryOp get_native_unary_operation(UnaryOperator op, BuiltinTypeId operand);
 
-// Bool
-Dict<StringRef, BoolOp::NativeBoolyOp> build_native_bool_operators();
+Compare::NativeCompOp
+get_native_cmp_operation(CmpOperator op, BuiltinTypeId lhs, BuiltinTypeId rhs);
 
-Dict<StringRef, BoolOp::NativeBoolyOp> const& native_bool_operators();
-
-BoolOp::NativeBoolyOp get_native_bool_operation(StringRef signature);
-
-// Unary
-Dict<StringRef, UnaryOp::NativeUnaryOp> build_native_unary_operators();
-
-Dict<StringRef, UnaryOp::NativeUnaryOp> const& native_unary_operators();
-
-UnaryOp::NativeUnaryOp get_native_unary_operation(StringRef signature);
-
-// Cmp
-Dict<StringRef, Compare::NativeCompOp> build_native_cmp_operators();
-
-Dict<StringRef, Compare::NativeCompOp> const& native_cmp_operators();
-
-Compare::NativeCompOp get_native_cmp_operation(StringRef signature);
-
-}  // namespace lython
\ No newline at end of file
+}  // namespace lython
@@ -3,6 +3,7 @@
 
 #include "cli/commands/code.h"
 #include "cli/commands/codegen.h"
+#include "cli/commands/compile.h"
 #include "cli/commands/debug.h"
 #include "cli/commands/doc.h"
 #include "cli/commands/format.h"
@@ -36,6 +37,7 @@ int main(int argc, const char* argv[]) {
     auto profile  = std::make_unique<ProfileCmd>();
     auto tests    = std::make_unique<TestsCmd>();
     auto internal = std::make_unique<InternalCmd>();
+    auto compile  = std::make_unique<CompileCmd>();
 
     // There is a problem when putting unique ptr inside the array :/
     Array<Command*> commands = {
@@ -48,6 +50,7 @@ int main(int argc, const char* argv[]) {
         profile.get(),
         tests.get(),
         internal.get(),
+        compile.get(),
     };
 
     // Main Parser
@@ -0,0 +1,91 @@
+#include "cli/commands/compile.h"
+
+#include "ast/ops.h"
+#include "lexer/buffer.h"
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "parser/precompiled.h"
+
+#include <iostream>
+
+namespace lython {
+argparse::ArgumentParser* CompileCmd::parser() {
+    argparse::ArgumentParser* p = new_parser();
+    p->add_description("Save parsed modules so they are not parsed again when imported");
+    p->add_argument("sources")  //
+        .remaining()            //
+        .help("Files to compile, foo.ly is saved as foo.lyc");
+
+    p->add_argument("--load")  //
+        .default_value(std::string())
+        .help("Load a compiled module and print it back");
+
+    return p;
+}
+
+int compile_file(String const& file) {
+    MappedFileBuffer reader(file);
+    Lexer            lex(reader);
+    Parser           parser(lex);
+
+    Unique<Module> mod(parser.parse_module());
+
+    // modules with syntax errors are not saved, their errors are printed instead
+    if (parser.has_errors()) {
+        parser.show_diagnostics(std::cout);
+        return -1;
+    }
+
+    String              path = module_file_path(file);
+    Array<ParsingError> errors;
+    if (!save_module(path, mod.get(), reader.hash(), reader.source().size(), &errors)) {
+        if (errors.empty()) {
+            std::cout << "Could not write " << path << std::endl;
+            return -1;
+        }
+
+        // the tokens of lazy bodies are not the ones of the lexer
+        ParsingErrorPrinter printer(std::cout);
+        printer.indent = 1;
+
+        std::cout << "Parsing error messages (" << errors.size() << ")\n";
+        for (ParsingError const& error: errors) {
+            std::cout << "  ";
+            printer.print(error);
+            std::cout << "\n";
+        }
+        return -1;
+    }
+    return 0;
+}
+
+int CompileCmd::main(argparse::ArgumentParser const& args) {
+    String load = String(args.get<std::string>("--load").c_str());
+
+    if (!load.empty()) {
+        MappedFileBuffer file(load);
+        Unique<Module>   mod(load_module(file.source()));
+
+        if (mod == nullptr) {
+            std::cout << load << " is not a compiled module" << std::endl;
+            return -1;
+        }
+        std::cout << str(mod.get()) << std::endl;
+        return 0;
+    }
+
+    if (!args.is_used("sources")) {
+        std::cout << "No sources provided" << std::endl;
+        return -1;
+    }
+
+    int status = 0;
+    for (std::string const& source: args.get<std::vector<std::string>>("sources")) {
+        if (compile_file(String(source.c_str())) != 0) {
+            status = -1;
+        }
+    }
+    return status;
+}
+
+}  // namespace lython
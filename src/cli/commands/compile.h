@@ -0,0 +1,14 @@
+#pragma once
+
+#include "cli/command.h"
+
+namespace lython {
+struct CompileCmd: public Command {
+    CompileCmd(): Command("compile") {}
+
+    virtual argparse::ArgumentParser* parser();
+
+    virtual int main(argparse::ArgumentParser const& args);
+};
+
+}  // namespace lython
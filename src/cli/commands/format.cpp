@@ -2,6 +2,7 @@
 
 #include "lexer/buffer.h"
 #include "lexer/lexer.h"
+#include "lexer/token_cache.h"
 #include "parser/parser.h"
 
 #include <filesystem>
@@ -44,6 +45,10 @@ argparse::ArgumentParser* FormatCmd::parser() {
         .help(
             "Allways dump parsed AST even if an error occured, (--inplace gets disabled on error)");
 
+    p->add_argument("--token-cache")  //
+        .default_value(std::string())
+        .help("Directory where the token streams are cached, unchanged files are not lexed again");
+
     return p;
 }
 
@@ -51,8 +56,8 @@ void find_regular_files(std::string const&              path,
                         std::vector<std::string> const& extensions,
                         Array<fs::path>&                out);
 bool has_extension(fs::path const& file, std::vector<std::string> const& extensions);
-int  ast_reformat_file(fs::path const& file, bool _ = false);
-int  tok_reformat_file(fs::path const& file, bool _ = false);
+int  ast_reformat_file(fs::path const& file, bool _ = false, String const& cache_dir = "");
+int  tok_reformat_file(fs::path const& file, bool _ = false, String const& cache_dir = "");
 
 int FormatCmd::main(argparse::ArgumentParser const& args) {
     //
@@ -72,7 +77,9 @@ int FormatCmd::main(argparse::ArgumentParser const& args) {
 
     info("Found {} files", regular_files.size());
 
-    bool ast = args.get<bool>("--ast");
+    bool   ast       = args.get<bool>("--ast");
+    String cache_dir = args.get<std::string>("--token-cache").c_str();
+
     if (args.get<bool>("fuzz")) {
         if (ast) {
             return ast_reformat_file("/dev/stdin", args.get<bool>("dump"));
@@ -85,9 +92,9 @@ int FormatCmd::main(argparse::ArgumentParser const& args) {
 
     for (auto const& path: regular_files) {
         if (ast) {
-            result += ast_reformat_file(path, args.get<bool>("dump"));
+            result += ast_reformat_file(path, args.get<bool>("dump"), cache_dir);
         } else {
-            result += tok_reformat_file(path);
+            result += tok_reformat_file(path, false, cache_dir);
         }
     }
 
@@ -126,29 +133,47 @@ bool has_extension(fs::path const& file, std::vector<std::string> const& extensi
     return false;
 }
 
-int tok_reformat_file(fs::path const& file, bool) {
+// Lexer reading the file, or replaying its cached tokens when a cache directory is given
+// the buffer and the cache need to outlive the lexer
+Unique<AbstractLexer> make_lexer(String const&           file,
+                                 String const&           cache_dir,
+                                 Unique<AbstractBuffer>& reader,
+                                 Unique<TokenCache>&     cache) {
+    reader = std::make_unique<MappedFileBuffer>(file);
+
+    if (cache_dir.empty()) {
+        return std::make_unique<Lexer>(*reader.get());
+    }
+
+    cache = std::make_unique<TokenCache>(*reader.get(), cache_dir);
+    return std::make_unique<ReplayLexer>(cache->tokens(), file);
+}
+
+int tok_reformat_file(fs::path const& file, bool, String const& cache_dir) {
     std::cout << "reformat: " << file << std::endl;
 
     String file_str = file.generic_string().c_str();
 
-    Unique<AbstractBuffer> reader = std::make_unique<FileBuffer>(file_str);
-    Lexer                  lex(*reader.get());
+    Unique<AbstractBuffer> reader;
+    Unique<TokenCache>     cache;
+    Unique<AbstractLexer>  lex = make_lexer(file_str, cache_dir, reader, cache);
 
     StringStream ss;
-    lex.print(ss);
+    lex->print(ss);
 
     std::cout << ss.str() << "\n";
     return 0;
 }
 
-int ast_reformat_file(fs::path const& file, bool dump) {
+int ast_reformat_file(fs::path const& file, bool dump, String const& cache_dir) {
     std::cout << "reformat: " << file << std::endl;
 
     String file_str = file.generic_string().c_str();
 
-    Unique<AbstractBuffer> reader = std::make_unique<FileBuffer>(file_str);
-    Lexer                  lex(*reader.get());
-    Parser                 parser(lex);
+    Unique<AbstractBuffer> reader;
+    Unique<TokenCache>     cache;
+    Unique<AbstractLexer>  lex = make_lexer(file_str, cache_dir, reader, cache);
+    Parser                 parser(*lex.get());
     Module*                mod = nullptr;
 
     mod = parser.parse_module();
@@ -53,7 +53,7 @@ int InternalCmd::main(argparse::ArgumentParser const& args) {
 
     std::unique_ptr<AbstractBuffer> reader;
     if (file != "") {
-        reader = std::make_unique<FileBuffer>(String(file.c_str()));
+        reader = std::make_unique<MappedFileBuffer>(String(file.c_str()));
     } else {
         reader = std::make_unique<ConsoleBuffer>();
     }
@@ -15,4 +15,18 @@ std::size_t xx_hash_3(void const* buffer, std::size_t size) noexcept {
     return XXH3_64bits(buffer, size);
 }
 
+XXHash3Stream::XXHash3Stream(): _state(XXH3_createState()) { reset(); }
+
+XXHash3Stream::~XXHash3Stream() { XXH3_freeState(static_cast<XXH3_state_t*>(_state)); }
+
+void XXHash3Stream::reset() noexcept { XXH3_64bits_reset(static_cast<XXH3_state_t*>(_state)); }
+
+void XXHash3Stream::update(void const* buffer, std::size_t size) noexcept {
+    XXH3_64bits_update(static_cast<XXH3_state_t*>(_state), buffer, size);
+}
+
+std::size_t XXHash3Stream::digest() const noexcept {
+    return XXH3_64bits_digest(static_cast<XXH3_state_t const*>(_state));
+}
+
 }  // namespace lython
\ No newline at end of file
@@ -5,4 +5,25 @@ namespace lython {
 
 std::size_t xx_hash_3(void const* buffer, std::size_t size) noexcept;
 
+// Incremental version of xx_hash_3, feeding the data in pieces
+// gives the same digest as hashing it in one go
+class XXHash3Stream {
+    public:
+    XXHash3Stream();
+
+    ~XXHash3Stream();
+
+    XXHash3Stream(XXHash3Stream const&) = delete;
+    XXHash3Stream& operator=(XXHash3Stream const&) = delete;
+
+    void reset() noexcept;
+
+    void update(void const* buffer, std::size_t size) noexcept;
+
+    std::size_t digest() const noexcept;
+
+    private:
+    void* _state = nullptr;
+};
+
 }  // namespace lython
\ No newline at end of file
@@ -4,9 +4,15 @@
 #define __STDC_WANT_SECURE_LIB__ 1
 
 #include <cstdio>
+#include <cstring>
 
 #ifndef __linux__
 #    define __STDC_LIB_EXT1__ 1
+#else
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
 #endif
 
 namespace lython {
@@ -32,6 +38,70 @@ FILE* internal_fopen(String filename) {
 
 AbstractBuffer::~AbstractBuffer() {}
 
+void AbstractBuffer::set_span(const char* begin, const char* end) {
+    _begin      = begin;
+    _end        = end;
+    _cursor     = begin;
+    _window_end = end;
+    _hashed     = false;
+
+    // Precompute the line offsets so fetching a line is a simple slice
+    _lines.clear();
+    _lines.push_back(0);
+
+    const char* it = begin;
+    while (it < end) {
+        it = static_cast<const char*>(memchr(it, '\n', std::size_t(end - it)));
+        if (it == nullptr) {
+            break;
+        }
+        it += 1;
+        _lines.push_back(uint32(it - begin));
+    }
+}
+
+uint64 AbstractBuffer::hash() {
+    if (_begin != nullptr) {
+        if (!_hashed) {
+            _hash   = uint64(xx_hash_3(_begin, std::size_t(_end - _begin)));
+            _hashed = true;
+        }
+        return _hash;
+    }
+
+    if (_stream == nullptr) {
+        return uint64(xx_hash_3(nullptr, 0));
+    }
+    return uint64(_stream->digest());
+}
+
+void AbstractBuffer::update_hash(const char* begin, const char* end) {
+    if (_stream == nullptr) {
+        _stream = std::make_unique<XXHash3Stream>();
+    }
+    _stream->update(begin, std::size_t(end - begin));
+}
+
+String AbstractBuffer::getline(int start_line, int end_line) {
+    int count = int(_lines.size());
+
+    if (_begin == nullptr || start_line < 1 || start_line > count) {
+        return String();
+    }
+
+    end_line = std::min(std::max(end_line, start_line), count);
+
+    const char* start = _begin + _lines[start_line - 1];
+    const char* stop  = _end;
+
+    // stop right before the newline that ends the last line
+    if (end_line < count) {
+        stop = _begin + _lines[end_line] - 1;
+    }
+
+    return String(start, stop);
+}
+
 FileBuffer::FileBuffer(String const& name): _file_name(name) {
 
     _file = internal_fopen(_file_name);
@@ -43,22 +113,60 @@ FileBuffer::~FileBuffer() { fclose(_file); }
 
 void FileBuffer::reset() {
     fseek(_file, 0, SEEK_SET);
+    _offset = 0;
     AbstractBuffer::reset();
 }
 
+void FileBuffer::record_lines(std::size_t read) {
+    std::size_t end = _offset + read;
+
+    // a reset reads the same blocks again
+    if (end > _scanned) {
+        const char* it   = _block + (std::max(_scanned, _offset) - _offset);
+        const char* stop = _block + read;
+
+        while (it < stop) {
+            it = static_cast<const char*>(memchr(it, '\n', std::size_t(stop - it)));
+            if (it == nullptr) {
+                break;
+            }
+            it += 1;
+            _line_offsets.push_back(uint64(_offset + std::size_t(it - _block)));
+        }
+        _scanned = end;
+    }
+
+    _offset = end;
+}
+
 String FileBuffer::getline(int start_line, int end_line) {
     fpos_t pos;
     fgetpos(_file, &pos);
     //--
 
+    end_line = std::max(end_line, start_line);
+
     String result;
     result.reserve(128);
-    fseek(_file, start_line, SEEK_SET);
 
-    char c = fgetc(_file);
+    // start from the closest line already read, usually the line itself
+    int line = std::max(std::min(start_line, int(_line_offsets.size())), 1);
+    fseek(_file, long(_line_offsets[line - 1]), SEEK_SET);
+
+    int c = fgetc(_file);
 
-    while (c != '\n') {
-        result.push_back(c);
+    while (c != EOF) {
+        if (c == '\n' && line == end_line) {
+            break;
+        }
+
+        if (line >= start_line) {
+            result.push_back(char(c));
+        }
+
+        if (c == '\n') {
+            line += 1;
+        }
         c = fgetc(_file);
     }
 
@@ -67,10 +175,73 @@ String FileBuffer::getline(int start_line, int end_line) {
     return result;
 }
 
+MappedFileBuffer::MappedFileBuffer(String const& name): _file_name(name) {
+#ifdef __linux__
+    int fd = open(name.c_str(), O_RDONLY);
+
+    if (fd < 0) {
+        throw FileError("{}: File `{}` does not exist", name);
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        void* data = mmap(nullptr, std::size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if (data != MAP_FAILED) {
+            _mapping = data;
+            _size    = std::size_t(st.st_size);
+            madvise(_mapping, _size, MADV_SEQUENTIAL);
+        }
+    }
+    close(fd);
+#endif
+
+    if (_mapping != nullptr) {
+        const char* data = static_cast<const char*>(_mapping);
+        set_span(data, data + _size);
+    } else {
+        _content = read_file(name);
+        set_span(_content.data(), _content.data() + _content.size());
+    }
+
+    init();
+}
+
+MappedFileBuffer::~MappedFileBuffer() {
+#ifdef __linux__
+    if (_mapping != nullptr) {
+        munmap(_mapping, _size);
+    }
+#endif
+}
+
 StringBuffer::~StringBuffer() {}
 
+ViewBuffer::~ViewBuffer() {}
+
 ConsoleBuffer::~ConsoleBuffer() {}
 
+String ConsoleBuffer::getline(int start_line, int end_line) {
+    int count = int(_history.size());
+
+    if (start_line < 1 || start_line > count) {
+        return String();
+    }
+
+    end_line = std::min(std::max(end_line, start_line), count);
+
+    String result;
+    for (int line = start_line; line <= end_line; line++) {
+        result.append(_history[line - 1]);
+    }
+
+    // like the other buffers, without the newline that ends the last line
+    if (!result.empty() && result.back() == '\n') {
+        result.pop_back();
+    }
+    return result;
+}
+
 String read_file(String const& name) {
     FILE* file = internal_fopen(name);
 
@@ -88,10 +259,13 @@ String read_file(String const& name) {
         auto& buffer = *(data.end() - 1);
 
         read = fread(&buffer[0], 1, buffer_size, file);
+        buffer.resize(read);
 
         total += read;
     } while (read == buffer_size);
 
+    fclose(file);
+
     String aggregated(total, ' ');
 
     ptrdiff_t start = 0;
@@ -101,7 +275,6 @@ String read_file(String const& name) {
         start += segment.size();
     }
 
-    debug("read {}", aggregated);
     return aggregated;
 }
 
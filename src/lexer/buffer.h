@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdio>
+#include <cstring>
 #include <string>
 
 #include "dependencies/coz_wrap.h"
@@ -10,27 +12,40 @@
 
 /*
  *  Buffers are special reader that keep track of current line/col and indent level
- *  they only need getc() to be defined to work properly
+ *
+ *  Buffers hand out their content one window [begin, end) at a time,
+ *  they only need refill() to be defined to work properly.
+ *  refill() is only called when the current window is exhausted so the cost of
+ *  the virtual call is paid once per block instead of once per character.
+ *
+ *  Buffers that can hold their whole content in memory expose it as a single
+ *  contiguous span, the window is the entire span and refill() is never needed
  *
  *  StringBuffer is made to make debugging easy (might be useful for
  *  the eval option and macro gen)
  *
- *  FileBuffer is the usual reader
+ *  FileBuffer is the stdio reader, it works on anything (pipes, stdin)
+ *
+ *  MappedFileBuffer is the usual reader, the file is mapped in memory
+ *
+ *  ViewBuffer reads a slice of memory it does not own
  */
 namespace lython {
 class AbstractBuffer {
     public:
-    virtual char          getc()      = 0;
+    // Fetch the next window of characters, returns false once the input is exhausted
+    virtual bool          refill() { return false; }
     virtual const String& file_name() = 0;
 
     AbstractBuffer() {}
 
     virtual ~AbstractBuffer();
 
-    void init() { _next_char = getc(); }
+    void init() { _next_char = nextc<AbstractBuffer>(); }
 
-    // TODO: add a hash digest compute
-    // so we can hash files with little overhead
+    // Self is the concrete type of the buffer when known,
+    // it allows the compiler to resolve refill() statically
+    template <typename Self = AbstractBuffer>
     void consume() {
         if (_next_char == EOF)
             return;
@@ -43,23 +58,24 @@ class AbstractBuffer {
 
             _indent     = 0;
             _empty_line = true;
-            _next_char  = getc();
+            _next_char  = nextc<Self>();
             return;
         }
 
         if (_next_char == ' ') {
             if (_empty_line)
                 _indent += 1;
-            _next_char = getc();
+            _next_char = nextc<Self>();
             return;
         }
 
         _empty_line = false;
-        _next_char  = getc();
+        _next_char  = nextc<Self>();
     }
 
     // Used to fetch a given line for error reporting
-    virtual String getline(int start_line, int end_line = -1) { return ""; }
+    // lines are 1-indexed like line(), end_line is inclusive
+    virtual String getline(int start_line, int end_line = -1);
 
     char  peek() { return _next_char; }
     int32 line() { return _line; }
@@ -67,21 +83,106 @@ class AbstractBuffer {
     int32 indent() { return _indent; }
     bool  empty_line() { return _empty_line; }
 
+    // Characters already available in memory, starting with peek()
+    // empty at the end of the input
+    StringView window() const {
+        if (_next_char == EOF) {
+            return StringView();
+        }
+        return StringView(_cursor - 1, std::size_t(_window_end - _cursor) + 1);
+    }
+
+    // Address of peek() in memory, end of the window at the end of the input
+    const char* position() const { return _next_char == EOF ? _cursor : _cursor - 1; }
+
+    // Consume the first n characters of window() in one step
+    // the run must not contain a newline
+    template <typename Self = AbstractBuffer>
+    void consume_run(std::size_t n) {
+        const char* run = _cursor - 1;
+
+        if (_empty_line) {
+            std::size_t k = 0;
+            while (k < n && run[k] == ' ') {
+                k += 1;
+            }
+            _indent += int32(k);
+            _empty_line = k == n;
+        }
+
+        _col += int32(n);
+        _cursor    = run + n;
+        _next_char = nextc<Self>();
+    }
+
+    // Whole content of the buffer, empty if the buffer is streamed block by block
+    StringView source() const { return StringView(_begin, std::size_t(_end - _begin)); }
+
+    // XXH3 digest of the content, used to key the caches.
+    // In-memory buffers hash their span on the first call,
+    // streamed buffers hash each block as it is read so their digest
+    // only covers the whole input once it has been consumed
+    uint64 hash();
+
     virtual void reset() {
         _next_char  = ' ';
         _line       = 1;
         _col        = 0;
         _indent     = 0;
         _empty_line = true;
+        _cursor     = _begin;
+        _window_end = _end;
+        if (_stream != nullptr) {
+            _stream->reset();
+        }
         init();
     }
 
+    protected:
+    // Buffers holding their content in memory call this once, the span is the only window
+    void set_span(const char* begin, const char* end);
+
+    // Streamed buffers call this from refill() with the block they just read
+    void set_window(const char* begin, const char* end) {
+        _cursor     = begin;
+        _window_end = end;
+        update_hash(begin, end);
+    }
+
     private:
+    void update_hash(const char* begin, const char* end);
+
+    template <typename Self>
+    char nextc() {
+        if (_cursor < _window_end) {
+            [[likely]] return *_cursor++;
+        }
+
+        if (static_cast<Self*>(this)->refill() && _cursor < _window_end) {
+            return *_cursor++;
+        }
+        return EOF;
+    }
+
     char  _next_char{' '};
     int32 _line = 1;
     int32 _col  = 0;
     int32 _indent{0};
     bool  _empty_line{true};
+
+    // current window
+    const char* _cursor     = nullptr;
+    const char* _window_end = nullptr;
+
+    // whole content for in-memory buffers
+    const char*   _begin = nullptr;
+    const char*   _end   = nullptr;
+    Array<uint32> _lines;  // offset of the first character of each line
+
+    // content digest
+    uint64                _hash   = 0;
+    bool                  _hashed = false;
+    Unique<XXHash3Stream> _stream;  // only used by streamed buffers
 };
 
 class FileError: public Exception {
@@ -92,20 +193,22 @@ class FileError: public Exception {
 
 String read_file(String const& name);
 
-class FileBuffer: public AbstractBuffer {
+class FileBuffer final: public AbstractBuffer {
     public:
     FileBuffer(String const& name);
 
     ~FileBuffer() override;
 
-    char getc() override {
-        COZ_BEGIN("T::FileBuffer::getc");
+    bool refill() override {
+        COZ_BEGIN("T::FileBuffer::refill");
 
-        char c = char(::getc(_file));
+        std::size_t read = fread(_block, 1, block_size, _file);
+        set_window(_block, _block + read);
+        record_lines(read);
 
-        COZ_PROGRESS_NAMED("FileBuffer::getc");
-        COZ_END("T::FileBuffer::getc");
-        return c;
+        COZ_PROGRESS_NAMED("FileBuffer::refill");
+        COZ_END("T::FileBuffer::refill");
+        return read > 0;
     }
 
     const String& file_name() override { return _file_name; }
@@ -115,88 +218,120 @@ class FileBuffer: public AbstractBuffer {
     String getline(int start_line, int end_line = -1) override;
 
     private:
+    // Remember where the lines of the block start, getline() seeks straight to them
+    void record_lines(std::size_t read);
+
+    static constexpr std::size_t block_size = 8192;
+
     String _file_name;
     FILE*  _file{nullptr};
+    char   _block[block_size];
+
+    std::size_t   _offset       = 0;    // offset of the block in the file
+    std::size_t   _scanned      = 0;    // bytes already looked at for newlines
+    Array<uint64> _line_offsets = {0};  // offset of the first character of each line read so far
+};
+
+// Maps the whole file in memory, the lexer reads straight from the mapped pages
+// Falls back to reading the file in memory when it cannot be mapped (pipes, /dev/stdin)
+class MappedFileBuffer final: public AbstractBuffer {
+    public:
+    MappedFileBuffer(String const& name);
+
+    ~MappedFileBuffer() override;
+
+    const String& file_name() override { return _file_name; }
+
+    private:
+    String      _file_name;
+    void*       _mapping = nullptr;
+    std::size_t _size    = 0;
+    String      _content;  // only used when the file could not be mapped
 };
 
-class StringBuffer: public AbstractBuffer {
+class StringBuffer final: public AbstractBuffer {
     public:
     StringBuffer(String code, String const& file = "c++ string"):
         _code(std::move(code)), _file_name(file) {
+        set_span(_code.data(), _code.data() + _code.size());
         init();
     }
 
-    char getc() override {
-        if (_pos >= _code.size())
-            return EOF;
-
-        _pos += 1;
-        return _code[_pos - 1];
-    }
-
     ~StringBuffer() override;
 
     const String& file_name() override { return _file_name; }
 
     private:
-    uint32       _pos{0};
     String       _code;
     const String _file_name;
 
     public:
-    void reset() override {
-        _pos = 0;
-        AbstractBuffer::reset();
-    }
-
-    String getline(int start_line, int end_line = -1) override {
-        uint32 old_pos = _pos;
-        //--
-
-        String result;
-        result.reserve(128);
-        _pos = start_line;
-
-        char c = getc();
-
-        while (c != '\n') {
-            result.push_back(c);
-            c = getc();
-        }
-
-        // --
-        _pos = old_pos;
-        return result;
-    }
-
     // helper for testing
     void read_all() {
         char c;
         do {
             c = peek();
-            consume();
+            consume<StringBuffer>();
         } while (c);
     }
 
     void load_code(const std::string& code) {
         _code = code;
-        _pos  = 0;
+        set_span(_code.data(), _code.data() + _code.size());
+    }
+};
+
+// Reads from memory owned by someone else (a slice of another buffer)
+// the memory needs to outlive the buffer and the tokens lexed from it
+class ViewBuffer final: public AbstractBuffer {
+    public:
+    ViewBuffer(StringView code, String const& file = "c++ view"): _file_name(file) {
+        set_span(code.data(), code.data() + code.size());
+        init();
     }
+
+    ~ViewBuffer() override;
+
+    const String& file_name() override { return _file_name; }
+
+    private:
+    const String _file_name;
 };
 
 // Quick solution but not satisfactory
-class ConsoleBuffer: public AbstractBuffer {
+class ConsoleBuffer final: public AbstractBuffer {
     public:
     ConsoleBuffer(): _file_name("console") { init(); }
 
-    char getc() override { return char(std::getchar()); }
+    // the console is line buffered, hand out one line at a time
+    bool refill() override {
+        if (std::fgets(_block, int(block_size), stdin) == nullptr) {
+            return false;
+        }
+        std::size_t n = strlen(_block);
+        set_window(_block, _block + n);
+
+        // a line longer than the block is read in several steps
+        if (_history.empty() || _history.back().back() == '\n') {
+            _history.emplace_back();
+        }
+        _history.back().append(_block, n);
+        return true;
+    }
 
     const String& file_name() override { return _file_name; }
 
+    // the console does not keep its input, the lines are read back from its history
+    String getline(int start_line, int end_line = -1) override;
+
     ~ConsoleBuffer() override;
 
     private:
-    const String _file_name;
+    static constexpr std::size_t block_size = 1024;
+
+    const String  _file_name;
+    char          _block[block_size];
+    Array<String> _history;  // lines read so far
 };
 
 }  // namespace lython
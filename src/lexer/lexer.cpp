@@ -1,70 +1,147 @@
 #include <spdlog/fmt/bundled/core.h>
 
 #include "lexer.h"
+#include "scan.h"
 #include "unlex.h"
 #include "utilities/strings.h"
 
 namespace lython {
 
 Dict<String, OpConfig> const& default_precedence() {
-    // clang-format off
     static Dict<String, OpConfig> val = {
-        // Predecence, Left Associative, is_binary, is_bool, can_be_unary, kind
-        // Arithmetic
-        {"+",       {20, true , tok_operator, BinaryOperator::Add, UnaryOperator::UAdd}},
-        {"-",       {20, true , tok_operator, BinaryOperator::Sub, UnaryOperator::USub}},
-        {"%",       {10, true , tok_operator, BinaryOperator::Mod}},
-        {"*",       {30, true , tok_operator, BinaryOperator::Mult}},
-        {"**",      {40, true , tok_operator, BinaryOperator::Pow}},
-        {"/",       {30, true , tok_operator, BinaryOperator::Div}},
-        {"//",      {30, true , tok_operator, BinaryOperator::FloorDiv}},
-        {".*",      {20, true , tok_operator, BinaryOperator::EltMult}},
-        {"./",      {20, true , tok_operator, BinaryOperator::EltDiv}},
-        //*/ Shorthand
-        {"+=",      {50, true , tok_augassign, BinaryOperator::Add}},
-        {"-=",      {50, true , tok_augassign, BinaryOperator::Sub}},
-        {"*=",      {50, true , tok_augassign, BinaryOperator::Mult}},
-        {"/=",      {50, true , tok_augassign, BinaryOperator::Div}},
-        {"%=",      {50, true , tok_augassign, BinaryOperator::Mod}},
-        {"**=",     {50, true , tok_augassign, BinaryOperator::Pow}},
-        {"//=",     {50, true , tok_augassign, BinaryOperator::FloorDiv}},
-        //*/
-        // Assignment
-        {"=",       {50, true , tok_assign}},
-        // Logic
-        {"~",       {40, false, tok_operator, BinaryOperator::None, UnaryOperator::Invert}},
-        {"<<",      {40, false, tok_operator, BinaryOperator::LShift}},
-        {">>",      {40, false, tok_operator, BinaryOperator::RShift}},
-        {"^",       {40, false, tok_operator, BinaryOperator::BitXor}},
-        {"&",       {40, true , tok_operator, BinaryOperator::BitAnd}},
-        {"and",     {40, true , tok_operator, BinaryOperator::None, UnaryOperator::None, BoolOperator::And}},
-        {"|",       {40, true , tok_operator, BinaryOperator::BitOr}},
-        {"or",      {40, true , tok_operator, BinaryOperator::None, UnaryOperator::None, BoolOperator::Or}},
-        {"!",       {40, true , tok_operator, BinaryOperator::None, UnaryOperator::Not}},
-        {"not",     {40, true , tok_operator, BinaryOperator::None, UnaryOperator::Not}},
-        // Comparison
-        {"==",      {40, true , tok_operator, BinaryOperator::None, UnaryOperator::None, BoolOperator::None, CmpOperator::Eq}},
-        {"!=",      {40, true , tok_operator, BinaryOperator::None, UnaryOperator::None, BoolOperator::None, CmpOperator::NotEq}},
-        {">=",      {40, true , tok_operator, BinaryOperator::None, UnaryOperator::None, BoolOperator::None, CmpOperator::GtE}},
-        {"<=",      {40, true , tok_operator, BinaryOperator::None, UnaryOperator::None, BoolOperator::None, CmpOperator::LtE}},
-        {">",       {40, true , tok_operator, BinaryOperator::None, UnaryOperator::None, BoolOperator::None, CmpOperator::Gt}},
-        {"<",       {40, true , tok_operator, BinaryOperator::None, UnaryOperator::None, BoolOperator::None, CmpOperator::Lt}},
-        // membership
-        {"in",      {40, false, tok_in      , BinaryOperator::None, UnaryOperator::None, BoolOperator::None, CmpOperator::In}},
-        {"not in",  {40, false, tok_in      , BinaryOperator::None, UnaryOperator::None, BoolOperator::None, CmpOperator::NotIn}},
-        // identity
-        {"is",      {40, false, tok_operator, BinaryOperator::None, UnaryOperator::None, BoolOperator::None, CmpOperator::Is}},
-        {"is not",  {40, false, tok_operator, BinaryOperator::None, UnaryOperator::None, BoolOperator::None, CmpOperator::IsNot}},
-        // Not an operator but we use same data structure for parsing
-        {"->",      {10, false, tok_arrow}},
-        {":=",      {10, false, tok_walrus}},
-        {":",       {10, false, (TokenType)':'}},
-        {".",       {60, true , tok_dot}},
+#define X(str, ...) {str, OpConfig{__VA_ARGS__}},
+        LYTHON_OPERATORS(X)
+#undef X
     };
-    // clang-format on
     return val;
 }
 
+// Reserved words and operators
+// -----------------------------
+// Lookup tables are generated at compile time from LYTHON_KEYWORDS and LYTHON_OPERATORS
+// they are shared by all the lexers and never allocate
+namespace {
+
+struct KeywordEntry {
+    StringView name;
+    TokenType  type;
+    int8       op;  // string operators (is, not, in, and, or) are lexed as operators
+};
+
+constexpr KeywordEntry keyword_list[] = {
+#define X(str, tok) {str, tok, operator_id(str)},
+    LYTHON_KEYWORDS(X)
+#undef X
+};
+
+constexpr int keyword_count = int(sizeof(keyword_list) / sizeof(keyword_list[0]));
+
+constexpr std::size_t max_keyword_size() {
+    std::size_t size = 0;
+    for (KeywordEntry const& keyword: keyword_list) {
+        size = keyword.name.size() > size ? keyword.name.size() : size;
+    }
+    return size;
+}
+
+// FNV-1a
+constexpr uint32 reserved_hash(StringView str, uint32 seed) {
+    uint32 hash = 2166136261u ^ seed;
+    for (char c: str) {
+        hash = (hash ^ uint8(c)) * 16777619u;
+    }
+    return hash;
+}
+
+// Perfect hash, the seed is searched at compile time so no keywords collide
+// the slot is taken from the high bits, the low bits of FNV do not depend on the seed enough
+constexpr uint32 keyword_bits  = 8;
+constexpr uint32 keyword_slots = 1 << keyword_bits;
+
+constexpr uint32 keyword_slot(StringView str, uint32 seed) {
+    return reserved_hash(str, seed) >> (32 - keyword_bits);
+}
+
+struct KeywordHash {
+    uint32 seed                 = 0;
+    uint8  slots[keyword_slots] = {};  // keyword index + 1, 0 is empty
+};
+
+constexpr KeywordHash make_keyword_hash() {
+    for (uint32 seed = 0;; seed++) {
+        KeywordHash table;
+        table.seed     = seed;
+        bool collision = false;
+
+        for (int i = 0; i < keyword_count && !collision; i++) {
+            uint32 slot       = keyword_slot(keyword_list[i].name, seed);
+            collision         = table.slots[slot] != 0;
+            table.slots[slot] = uint8(i + 1);
+        }
+
+        if (!collision) {
+            return table;
+        }
+    }
+}
+
+constexpr KeywordHash keyword_hash = make_keyword_hash();
+
+// returns the index of the keyword or -1
+int keyword_lookup(StringView name) {
+    if (name.size() > max_keyword_size()) {
+        return -1;
+    }
+
+    uint8 slot = keyword_hash.slots[keyword_slot(name, keyword_hash.seed)];
+    if (slot != 0 && keyword_list[slot - 1].name == name) {
+        return slot - 1;
+    }
+    return -1;
+}
+
+// Operator DFA, one state per operator prefix
+// word operators (and, is not, ...) start like identifiers and are found by keyword_lookup
+constexpr int operator_states = 64;
+
+struct OperatorDFA {
+    int8 next[operator_states][128] = {};  // 0 is no transition, the root is never a target
+    int8 accept[operator_states]    = {};  // operator id, 0 is not accepting
+    int  size                       = 1;
+};
+
+constexpr bool is_word_start(char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'); }
+
+constexpr OperatorDFA make_operator_dfa() {
+    OperatorDFA dfa;
+
+    for (int i = 1; i < operator_count; i++) {
+        StringView name = operator_table[i].name;
+        if (is_word_start(name[0])) {
+            continue;
+        }
+
+        int state = 0;
+        for (char c: name) {
+            if (dfa.next[state][int(c)] == 0) {
+                dfa.next[state][int(c)] = int8(dfa.size);
+                dfa.size += 1;
+            }
+            state = dfa.next[state][int(c)];
+        }
+        dfa.accept[state] = int8(i);
+    }
+    return dfa;
+}
+
+constexpr OperatorDFA operator_dfa = make_operator_dfa();
+
+inline int operator_transition(int state, char c) {
+    return c > 0 ? operator_dfa.next[state][int(c)] : 0;
+}
+
+}  // namespace
+
 std::ostream& AbstractLexer::debug_print(std::ostream& out) {
 
     Token t = next_token();
@@ -96,16 +173,37 @@ std::ostream& AbstractLexer::print(std::ostream& out) {
 
     return out;
 }
-Token const& Lexer::next_token() {
-    _count += 1;
-
-    // if we peeked ahead return that one
-    if (_buffer.size() > 0) {
-        _token = _buffer[_buffer.size() - 1];
-        _buffer.pop_back();
-        return _token;
+template <typename Buffer>
+void BufferLexer<Buffer>::lex_next() {
+    Token const& tok = lex_token();
+
+    // combine is not & not in
+    if (_ahead > 0) {
+        Token& last = _ring[(_head + _ahead) & ring_mask];
+
+        if (last.type() == tok_operator) {
+            constexpr int8 op_is  = operator_id("is");
+            constexpr int8 op_not = operator_id("not");
+
+            if (last.operator_id() == op_is && tok.operator_id() == op_not) {
+                constexpr int8 op = operator_id("is not");
+                last = Token(last.type(), tok.line(), tok.col(), operator_table[op].name, op);
+                return;
+            }
+
+            if (last.operator_id() == op_not && tok.type() == tok_in) {
+                constexpr int8 op = operator_id("not in");
+                last = Token(last.type(), tok.line(), tok.col(), operator_table[op].name, op);
+                return;
+            }
+        }
     }
 
+    _ahead += 1;
+}
+
+template <typename Buffer>
+Token const& BufferLexer<Buffer>::lex_token() {
     char c = peek();
 
     // newline
@@ -140,7 +238,7 @@ Token const& Lexer::next_token() {
 
         // if current indent is the same do nothing
         if (_cindent <= _oindent)
-            return next_token();
+            return lex_token();
 
         // else increase indent
         return make_token(tok_indent);
@@ -204,59 +302,35 @@ Token const& Lexer::next_token() {
     }
 
     // remove white space
-    while (c == ' ') {
-        c = nextc();
+    if (c == ' ') {
+        c = take_run(nullptr, scanners().spaces);
     }
 
     // Identifiers
     // -----------
     if ((isalpha(c) || c == '_') && peek() != '"') {
-        String identifier;
-
         // FIXME: check that ident can be an identifier
-        identifier.push_back(c);
-
-        while (is_identifier(c = nextc())) {
-            identifier.push_back(c);
-        }
+        text_begin();
+        c                     = take_run(text_run(), scanners().identifier);
+        StringView identifier = text_end();
 
         if (c == 'f') {
             goto strings;
         }
 
-        // is it a string operator (is, not, in, and, or) ?
-        {
-            auto result = default_precedence().find(identifier);
-            if (result != default_precedence().end()) {
-                OpConfig const& conf = result->second;
-                Token           tok  = dummy();
-
-                // combine is not & not in right now
-                if (identifier == "is" || identifier == "not") {
-                    tok = next_token();
-                } else {
-                    return make_token(conf.type, identifier);
-                }
-
-                if (identifier == "is" && tok.operator_name() == "not") {
-                    return make_token(conf.type, "is not");
-                }
+        int index = keyword_lookup(identifier);
 
-                if (identifier == "not" && tok.operator_name() == "in") {
-                    return make_token(conf.type, "not in");
-                }
-
-                _buffer.push_back(tok);
-                return make_token(conf.type, identifier);
-            }
+        // is it a string operator (is, not, in, and, or) ?
+        // is not & not in are combined by lex_next()
+        if (index >= 0 && keyword_list[index].op > 0) {
+            int8                 op    = keyword_list[index].op;
+            OperatorEntry const& entry = operator_table[op];
+            return make_token(entry.config.type, entry.name, op);
         }
 
         // is it a keyword ?
-        {
-            auto result = keywords().find(identifier);
-            if (result != keywords().end()) {
-                return make_token(result->second);
-            }
+        if (index >= 0) {
+            return make_token(keyword_list[index].type);
         }
 
         // then it must be an identifier
@@ -266,48 +340,39 @@ Token const& Lexer::next_token() {
     // Operators
     // -----------------------------------------------
     // c is not alpha num
-    {
-        auto next = _operators.match(c);
-        if (next != nullptr) {
-            String op;
-            op.reserve(6);
-            auto prev = next;
-
-            while (next != nullptr) {
-                op.push_back(c);
-                c    = nextc();
-                prev = next;
-                next = prev->matching(c);
-            }
+    if (operator_transition(0, c) != 0) {
+        int state = 0;
+        int next  = 0;
+
+        // longest match
+        while ((next = operator_transition(state, c)) != 0) {
+            state = next;
+            c     = nextc();
+        }
 
-            if (prev->leaf()) {
-                op          = strip(op);
-                auto result = default_precedence().find(op);
-                if (result != default_precedence().end()) {
-                    OpConfig const& conf = result->second;
-                    return make_token(conf.type, op);
-                }
-            }
+        if (int8 op = operator_dfa.accept[state]) {
+            OperatorEntry const& entry = operator_table[op];
+            return make_token(entry.config.type, entry.name, op);
         }
     }
 
     // Numbers
     // -----------------------------------------------
     if (std::isdigit(c)) {
-        String    num;
         TokenType ntype = tok_int;
+        text_begin();
 
         while (std::isdigit(c)) {
-            num.push_back(c);
+            text_push(c);
             c = nextc();
         }
 
         if (c == '.') {
             ntype = tok_float;
-            num.push_back(c);
+            text_push(c);
             c = nextc();
             while (std::isdigit(c)) {
-                num.push_back(c);
+                text_push(c);
                 c = nextc();
             }
         }
@@ -321,7 +386,7 @@ Token const& Lexer::next_token() {
 
         // std::cout << '"' << num << '"' << ntype << ',' << tok_incorrect << std::endl;
         // throw 0;
-        return make_token(ntype, num);
+        return make_token(ntype, text_end());
     }
 
 // Strings
@@ -343,49 +408,66 @@ strings:
     // Regular string
     // --------------
     if (c == '"') {
-        String    str;
-        TokenType tok = tok_string;
-        char      c2  = nextc();
-        char      c3  = '\0';
+        StringView str;
+        TokenType  tok = tok_string;
+        char       c2  = nextc();
+        char       c3  = '\0';
 
         if (c2 == '"') {
-            char c3 = nextc();
-            if (c3 == '"') {
-                tok = tok_docstring;
-            } else {
-                str.push_back(c2);
-                str.push_back(c3);
+            c3 = nextc();
+            if (c3 != '"') {
+                // empty string, c3 belongs to the next token
+                return make_token(tok, str);
             }
-        } else {
-            str.push_back(c2);
+            tok = tok_docstring;
         }
 
-        if (tok == tok_string)
-            while ((c = nextc()) != '"' && c != EOF) {
-                str.push_back(c);
+        if (tok == tok_string) {
+            text_begin();
+            c = c2;
+            while (c != '"' && c != EOF) {
+                c = take_run(text_run(), scanners().string);
+
+                if (c == '\n') {
+                    text_push(c);
+                    c = nextc();
+                }
             }
-        else {
-            while (c != EOF) {
-                c = nextc();
+            str = text_end();
+        } else {
+            // eat the third quote
+            consume();
+            text_begin();
+
+            while (true) {
+                c = take_run(text_run(), scanners().string);
+
+                if (c == EOF) {
+                    str = text_end();
+                    break;
+                }
 
                 if (c == '"') {
                     c2 = nextc();
                     if (c2 == '"') {
                         c3 = nextc();
                         if (c3 == '"') {
+                            // the first two closing quotes are already consumed
+                            str = text_end(2);
                             break;
                         } else {
-                            str.push_back(c);
-                            str.push_back(c2);
-                            str.push_back(c3);
+                            text_push(c);
+                            text_push(c2);
+                            text_push(c3);
                         }
                     } else {
-                        str.push_back(c);
-                        str.push_back(c2);
+                        text_push(c);
+                        text_push(c2);
                     }
                 } else {
-                    str.push_back(c);
+                    text_push(c);
                 }
+                consume();
             }
         }
         consume();
@@ -394,19 +476,14 @@ strings:
 
     c = peek();
     if (c == tok_comment) {
-        String comment;
-        comment.reserve(128);
-
         // eat the comment token
-        c = nextc();
+        consume();
 
         // eat all characters until the newline
-        while (c != '\n' && c != EOF) {
-            comment.push_back(c);
-            c = nextc();
-        };
+        text_begin();
+        take_run(text_run(), scanners().line);
 
-        return make_token(tok_comment, comment);
+        return make_token(tok_comment, text_end());
     }
 
     // get next char
@@ -419,4 +496,11 @@ strings:
     return make_token(tok_incorrect);
 }
 
+template class BufferLexer<AbstractBuffer>;
+template class BufferLexer<StringBuffer>;
+template class BufferLexer<FileBuffer>;
+template class BufferLexer<MappedFileBuffer>;
+template class BufferLexer<ConsoleBuffer>;
+template class BufferLexer<ViewBuffer>;
+
 }  // namespace lython
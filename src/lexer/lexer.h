@@ -6,7 +6,6 @@
 #include "ast/nodes.h"
 #include "lexer/buffer.h"
 #include "lexer/token.h"
-#include "utilities/trie.h"
 
 #include "dtypes.h"
 
@@ -53,26 +52,90 @@ struct OpConfig {
     }
 };
 
-Dict<String, OpConfig> const& default_precedence();
+// Operators recognized by the lexer
+// X(str, precedence, left_associative, type, binarykind, unarykind, boolkind, cmpkind)
+// trailing kinds default to None
+//
+// clang-format off
+#define LYTHON_OPERATORS(X)                                                                                                 \
+    /* Arithmetic */                                                                                                        \
+    X("+",      20, true , tok_operator, BinaryOperator::Add, UnaryOperator::UAdd)                                          \
+    X("-",      20, true , tok_operator, BinaryOperator::Sub, UnaryOperator::USub)                                          \
+    X("%",      10, true , tok_operator, BinaryOperator::Mod)                                                               \
+    X("*",      30, true , tok_operator, BinaryOperator::Mult)                                                              \
+    X("**",     40, true , tok_operator, BinaryOperator::Pow)                                                               \
+    X("/",      30, true , tok_operator, BinaryOperator::Div)                                                               \
+    X("//",     30, true , tok_operator, BinaryOperator::FloorDiv)                                                          \
+    X(".*",     20, true , tok_operator, BinaryOperator::EltMult)                                                           \
+    X("./",     20, true , tok_operator, BinaryOperator::EltDiv)                                                            \
+    /* Shorthand */                                                                                                         \
+    X("+=",     50, true , tok_augassign, BinaryOperator::Add)                                                              \
+    X("-=",     50, true , tok_augassign, BinaryOperator::Sub)                                                              \
+    X("*=",     50, true , tok_augassign, BinaryOperator::Mult)                                                             \
+    X("/=",     50, true , tok_augassign, BinaryOperator::Div)                                                              \
+    X("%=",     50, true , tok_augassign, BinaryOperator::Mod)                                                              \
+    X("**=",    50, true , tok_augassign, BinaryOperator::Pow)                                                              \
+    X("//=",    50, true , tok_augassign, BinaryOperator::FloorDiv)                                                         \
+    /* Assignment */                                                                                                        \
+    X("=",      50, true , tok_assign)                                                                                      \
+    /* Logic */                                                                                                             \
+    X("~",      40, false, tok_operator, BinaryOperator::None, UnaryOperator::Invert)                                       \
+    X("<<",     40, false, tok_operator, BinaryOperator::LShift)                                                            \
+    X(">>",     40, false, tok_operator, BinaryOperator::RShift)                                                            \
+    X("^",      40, false, tok_operator, BinaryOperator::BitXor)                                                            \
+    X("&",      40, true , tok_operator, BinaryOperator::BitAnd)                                                            \
+    X("and",    40, true , tok_operator, BinaryOperator::None, UnaryOperator::None, BoolOperator::And)                      \
+    X("|",      40, true , tok_operator, BinaryOperator::BitOr)                                                             \
+    X("or",     40, true , tok_operator, BinaryOperator::None, UnaryOperator::None, BoolOperator::Or)                       \
+    X("!",      40, true , tok_operator, BinaryOperator::None, UnaryOperator::Not)                                          \
+    X("not",    40, true , tok_operator, BinaryOperator::None, UnaryOperator::Not)                                          \
+    /* Comparison */                                                                                                        \
+    X("==",     40, true , tok_operator, BinaryOperator::None, UnaryOperator::None, BoolOperator::None, CmpOperator::Eq)    \
+    X("!=",     40, true , tok_operator, BinaryOperator::None, UnaryOperator::None, BoolOperator::None, CmpOperator::NotEq) \
+    X(">=",     40, true , tok_operator, BinaryOperator::None, UnaryOperator::None, BoolOperator::None, CmpOperator::GtE)   \
+    X("<=",     40, true , tok_operator, BinaryOperator::None, UnaryOperator::None, BoolOperator::None, CmpOperator::LtE)   \
+    X(">",      40, true , tok_operator, BinaryOperator::None, UnaryOperator::None, BoolOperator::None, CmpOperator::Gt)    \
+    X("<",      40, true , tok_operator, BinaryOperator::None, UnaryOperator::None, BoolOperator::None, CmpOperator::Lt)    \
+    /* membership */                                                                                                        \
+    X("in",     40, false, tok_in      , BinaryOperator::None, UnaryOperator::None, BoolOperator::None, CmpOperator::In)    \
+    X("not in", 40, false, tok_in      , BinaryOperator::None, UnaryOperator::None, BoolOperator::None, CmpOperator::NotIn) \
+    /* identity */                                                                                                          \
+    X("is",     40, false, tok_operator, BinaryOperator::None, UnaryOperator::None, BoolOperator::None, CmpOperator::Is)    \
+    X("is not", 40, false, tok_operator, BinaryOperator::None, UnaryOperator::None, BoolOperator::None, CmpOperator::IsNot) \
+    /* Not an operator but we use same data structure for parsing */                                                        \
+    X("->",     10, false, tok_arrow)                                                                                       \
+    X(":=",     10, false, tok_walrus)                                                                                      \
+    X(":",      10, false, (TokenType)':')                                                                                  \
+    X(".",      60, true , tok_dot)
+// clang-format on
 
-class LexerOperators {
-    public:
-    LexerOperators() {
-        for (auto& c: _precedence_table) {
-            _operators.insert(c.first);
-        }
-    }
+Dict<String, OpConfig> const& default_precedence();
 
-    Trie<128> const* match(int c) const { return _operators.trie().matching(c); }
+struct OperatorEntry {
+    StringView name;
+    OpConfig   config;
+};
 
-    Dict<String, OpConfig> const& precedence_table() const { return _precedence_table; }
+// Dense operator table indexed by Token::operator_id()
+// ids follow LYTHON_OPERATORS starting at 1, entry 0 is used by tokens that are not operators
+inline constexpr OperatorEntry operator_table[] = {
+    {"", OpConfig{}},
+#define X(str, ...) {str, OpConfig{__VA_ARGS__}},
+    LYTHON_OPERATORS(X)
+#undef X
+};
 
-    TokenType token_type(String const& str) const { return _precedence_table.at(str).type; }
+inline constexpr int operator_count = int(sizeof(operator_table) / sizeof(operator_table[0]));
 
-    private:
-    CoWTrie<128>           _operators;
-    Dict<String, OpConfig> _precedence_table = default_precedence();
-};
+// Resolved at compile time when name is a literal
+constexpr int8 operator_id(StringView name) {
+    for (int i = 1; i < operator_count; i++) {
+        if (operator_table[i].name == name) {
+            return int8(i);
+        }
+    }
+    return 0;
+}
 
 class AbstractLexer {
     public:
@@ -82,10 +145,21 @@ class AbstractLexer {
 
     virtual Token const& peek_token() = 0;
 
+    // k-th token after token(), peek(1) is peek_token()
+    virtual Token const& peek(int k) = 0;
+
     virtual Token const& token() = 0;
 
     virtual const String& file_name() = 0;
 
+    // Tokens kept in memory by the lexer and the index of token() among them,
+    // lexers streaming their tokens do not keep the ones already read
+    virtual Array<Token> const* tokens() const { return nullptr; }
+    virtual std::size_t         index() const { return 0; }
+
+    // Source of the lines [first, last], empty if it cannot be read back
+    virtual String getline(int, int) { return String(); }
+
     // print tokens with their info
     ::std::ostream& debug_print(::std::ostream& out);
 
@@ -108,97 +182,163 @@ class AbstractLexer {
 
 class ReplayLexer: public AbstractLexer {
     public:
-    ReplayLexer(Array<Token>& tokens): tokens(tokens) {
+    ReplayLexer(Array<Token>& tokens, String const& file = "<replay buffer>"):
+        _tokens(tokens), _file_name(file) {
         Token& last = tokens[tokens.size() - 1];
         if (last.type() != tok_eof) {
             tokens.emplace_back(tok_eof, 0, 0);
         }
     }
 
+    // like the streaming lexers, the first token is returned
+    // by the first call to either token() or next_token()
     Token const& next_token() override final {
-        if (i + 1 < tokens.size())
+        if (!started)
+            started = true;
+        else if (i + 1 < _tokens.size())
             i += 1;
 
-        return tokens[i];
+        return _tokens[i];
     }
 
-    Token const& peek_token() override final {
-        auto n = i + 1;
+    Token const& peek_token() override final { return peek(1); }
 
-        if (n >= tokens.size())
-            n = i;
+    Token const& peek(int k) override final {
+        auto n = started ? i + k : i + k - 1;
 
-        return tokens[n];
-    }
+        if (n >= _tokens.size())
+            n = _tokens.size() - 1;
 
-    Token const& token() override final { return tokens[i]; }
+        return _tokens[n];
+    }
 
-    const String& file_name() override {
-        static String fakefile = "<replay buffer>";
-        return fakefile;
+    Token const& token() override final {
+        started = true;
+        return _tokens[i];
     }
 
+    const String& file_name() override { return _file_name; }
+
+    Array<Token> const* tokens() const override { return &_tokens; }
+    std::size_t         index() const override { return i; }
+
     ~ReplayLexer() {}
 
     private:
-    ::std::size_t i = 0;
-    Array<Token>& tokens;
+    ::std::size_t i       = 0;
+    bool          started = false;
+    Array<Token>& _tokens;
+    const String  _file_name;
 };
 
-class Lexer: public AbstractLexer {
+// Lexer parametrized by the concrete buffer type it reads from,
+// when the type is known the buffer calls get inlined in the hot loops of next_token
+template <typename Buffer>
+class BufferLexer: public AbstractLexer {
     public:
-    Lexer(AbstractBuffer& reader):
+    BufferLexer(Buffer& reader):
         AbstractLexer(), _reader(reader), _cindent(indent()), _oindent(indent()) {}
 
-    ~Lexer() {}
+    ~BufferLexer() {}
+
+    // Number of tokens that can be looked ahead
+    static constexpr int lookahead = 6;
 
     Token const& token() override final {
         if (_count == 0) {
             return next_token();
         }
-        return _token;
+        return _ring[_head];
     }
-    Token const& next_token() override final;
-    Token const& peek_token() override final {
-        // we can only peek ahead once
-        if (_buffer.size() > 0)
-            return _buffer[_buffer.size() - 1];
 
-        // Save current token a get next
-        Token current_token = _token;
-        _buffer.push_back(next_token());
-        _token = current_token;
-        return _buffer[_buffer.size() - 1];
+    Token const& next_token() override final {
+        fill(1);
+
+        _count += 1;
+        _head  = (_head + 1) & ring_mask;
+        _ahead -= 1;
+        return _ring[_head];
+    }
+
+    Token const& peek_token() override final { return peek(1); }
+
+    Token const& peek(int k) override final {
+        assert_true(k > 0 && k <= lookahead, "Lookahead is limited", "k <= lookahead", LOC);
+
+        // looking further would overwrite the tokens we are looking at
+        k = std::min(std::max(k, 1), lookahead);
+        fill(k);
+        return _ring[(_head + k) & ring_mask];
     }
 
+    // new tokens are written in the first free slot of the ring,
+    // they become visible once lex_next() accepts them
     Token const& make_token(int8 t) {
-        _token = Token(t, line(), col());
-        return _token;
+        Token& slot = _ring[(_head + _ahead + 1) & ring_mask];
+        slot        = Token(t, line(), col());
+        return slot;
     }
 
-    Token const& make_token(int8 t, const String& identifier) {
-        _token              = Token(t, line(), col());
-        _token.identifier() = identifier;
-        return _token;
+    Token const& make_token(int8 t, StringView text, int8 op = 0) {
+        Token& slot = _ring[(_head + _ahead + 1) & ring_mask];
+        slot        = Token(t, line(), col(), text, op);
+        return slot;
     }
 
     const String& file_name() override { return _reader.file_name(); }
 
+    String getline(int first, int last) override { return _reader.getline(first, last); }
+
+    // Indentation of the last line, needed to stitch token streams together
+    int32 indentation() const { return _oindent; }
+
     private:
-    int             _count = 0;
-    AbstractBuffer& _reader;
-    Token           _token{dummy()};
-    int32           _cindent;
-    int32           _oindent;
-    LexerOperators  _operators;
-    Array<Token>    _buffer;
+    // lex a single token
+    Token const& lex_token();
+
+    // lex the next token and combine it with the previous one if needed
+    void lex_next();
+
+    // make sure k tokens after token() are ready
+    void fill(int k) {
+        while (_ahead < k || (_ahead == k && is_combinable(_ring[(_head + _ahead) & ring_mask]))) {
+            lex_next();
+        }
+    }
+
+    // `is` and `not` are not final until we know if `not` or `in` follows
+    static bool is_combinable(Token const& tok) {
+        constexpr int8 op_is  = operator_id("is");
+        constexpr int8 op_not = operator_id("not");
+        return tok.operator_id() == op_is || tok.operator_id() == op_not;
+    }
+
+    // current token, lookahead and one slot for the token being lexed
+    static constexpr int ring_size = 8;
+    static constexpr int ring_mask = ring_size - 1;
+    static_assert(lookahead + 2 <= ring_size, "Ring is too small for the lookahead");
+
+    int     _count = 0;
+    Buffer& _reader;
+    int32   _cindent;
+    int32   _oindent;
+    Token   _ring[ring_size];
+    int     _head  = 0;  // position of token()
+    int     _ahead = 0;  // number of tokens lexed after token()
+
+    // Token text
+    // in-memory buffers hand out spans of their source,
+    // text read from streamed buffers is copied in blocks owned by the lexer
+    const char*  _mark = nullptr;
+    String       _scratch;
+    List<String> _text;
 
     // shortcuts
 
     int32 line() { return _reader.line(); }
     int32 col() { return _reader.col(); }
     int32 indent() { return _reader.indent(); }
-    void  consume() { return _reader.consume(); }
+    void  consume() { return _reader.template consume<Buffer>(); }
     char  peek() { return _reader.peek(); }
     bool  empty_line() { return _reader.empty_line(); }
 
@@ -206,16 +346,83 @@ class Lexer: public AbstractLexer {
     bool desindent_for_comment = false;
 
     char nextc() {
-        _reader.consume();
+        consume();
         return _reader.peek();
     }
 
-    // what characters are allowed in identifiers
-    bool is_identifier(char c) {
-        if (::std::isalnum(c) || c == '_' || c == '?' || c == '!' || c == '-')
-            return true;
-        return false;
+    bool in_memory() const { return _reader.source().data() != nullptr; }
+
+    // Start the text of a token at peek()
+    void text_begin() {
+        _mark = _reader.position();
+        _scratch.clear();
+    }
+
+    // characters only need to be saved when they are not kept in memory by the buffer
+    void text_push(char c) {
+        if (!in_memory() && c != EOF) {
+            _scratch.push_back(c);
+        }
+    }
+
+    String* text_run() { return in_memory() ? nullptr : &_scratch; }
+
+    // Text from text_begin() to peek(),
+    // `closing` consumed characters are excluded from the span (in-memory only, they were never pushed)
+    StringView text_end(std::size_t closing = 0) {
+        if (in_memory()) {
+            return StringView(_mark, std::size_t(_reader.position() - _mark) - closing);
+        }
+
+        std::size_t n = _scratch.size();
+        if (_text.empty() || _text.back().capacity() - _text.back().size() < n) {
+            _text.emplace_back();
+            _text.back().reserve(std::max(n, std::size_t(4096)));
+        }
+
+        // the block never grows past its capacity, previous tokens stay valid
+        String&     block = _text.back();
+        const char* text  = block.data() + block.size();
+        block.append(_scratch);
+        return StringView(text, n);
+    }
+
+    // Consume the run of characters accepted by scan starting at peek()
+    // and append it to out, returns the first character that is not part of the run
+    char take_run(String* out, const char* (*scan)(const char*, const char*)) {
+        StringView window = _reader.window();
+
+        while (!window.empty()) {
+            const char* end  = window.data() + window.size();
+            const char* stop = scan(window.data(), end);
+            std::size_t n    = std::size_t(stop - window.data());
+
+            if (n == 0) {
+                break;
+            }
+            if (out != nullptr) {
+                out->append(window.data(), n);
+            }
+            _reader.template consume_run<Buffer>(n);
+
+            if (stop != end) {
+                break;
+            }
+            // the run continues in the next window
+            window = _reader.window();
+        }
+        return _reader.peek();
     }
 };
 
+// Generic lexer, reads from any buffer through its base class
+using Lexer = BufferLexer<AbstractBuffer>;
+
+extern template class BufferLexer<AbstractBuffer>;
+extern template class BufferLexer<StringBuffer>;
+extern template class BufferLexer<FileBuffer>;
+extern template class BufferLexer<MappedFileBuffer>;
+extern template class BufferLexer<ConsoleBuffer>;
+extern template class BufferLexer<ViewBuffer>;
+
 }  // namespace lython
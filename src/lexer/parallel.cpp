@@ -0,0 +1,156 @@
+#include "lexer/parallel.h"
+#include "lexer/lexer.h"
+#include "utilities/pool.h"
+
+#include <cstring>
+#include <future>
+
+namespace lython {
+
+namespace {
+
+bool is_split_start(char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_'; }
+
+// Lines are counted as we go, returns the position after the needle
+std::size_t skip_until(StringView source, std::size_t i, StringView needle, int32& line) {
+    std::size_t end = source.find(needle, i);
+    end             = end == StringView::npos ? source.size() : end + needle.size();
+
+    for (std::size_t k = i; k < end; k++) {
+        line += source[k] == '\n';
+    }
+    return end;
+}
+
+struct Chunk {
+    Array<Token> tokens;
+    int32        indentation = 0;
+};
+
+Chunk lex_chunk(StringView source, String const& file_name) {
+    ViewBuffer              reader(source, file_name);
+    BufferLexer<ViewBuffer> lex(reader);
+
+    Chunk chunk;
+    chunk.tokens      = lex.extract_token();
+    chunk.indentation = lex.indentation();
+    return chunk;
+}
+
+}  // namespace
+
+// This follows the rules of the lexer for strings and comments
+// the lexer does not track brackets, they are only here so chunks end on complete statements
+Array<SplitPoint> find_split_points(StringView source, std::size_t chunk_size) {
+    Array<SplitPoint> points;
+
+    std::size_t n     = source.size();
+    std::size_t i     = 0;
+    std::size_t last  = 0;
+    int32       line  = 1;
+    int         depth = 0;
+
+    while (i < n) {
+        switch (source[i]) {
+        case '\n': {
+            line += 1;
+            i += 1;
+
+            if (depth == 0 && i - last >= chunk_size && i < n && is_split_start(source[i])) {
+                points.push_back({i, line});
+                last = i;
+            }
+            continue;
+        }
+        case '#': {
+            // the newline is not part of the comment
+            std::size_t end = source.find('\n', i);
+            i               = end == StringView::npos ? n : end;
+            continue;
+        }
+        case '(':
+        case '[':
+        case '{': depth += 1; break;
+        case ')':
+        case ']':
+        case '}': depth = std::max(depth - 1, 0); break;
+        case '"': {
+            if (source.substr(i, 3) == "\"\"\"") {
+                i = skip_until(source, i + 3, "\"\"\"", line);
+            } else if (source.substr(i, 2) == "\"\"") {
+                // empty string
+                i += 2;
+            } else {
+                i = skip_until(source, i + 1, "\"", line);
+            }
+            continue;
+        }
+        }
+        i += 1;
+    }
+
+    return points;
+}
+
+Array<Token> parallel_lex(AbstractBuffer& reader, ThreadPool& pool, std::size_t chunk_size) {
+    StringView source = reader.source();
+
+    // a single worker would only add overhead
+    Array<SplitPoint> points;
+    if (source.data() != nullptr && pool.size() > 1) {
+        points = find_split_points(source, chunk_size);
+    }
+
+    if (points.empty()) {
+        Lexer lex(reader);
+        return lex.extract_token();
+    }
+
+    // chunk i goes from points[i - 1] to points[i]
+    points.insert(points.begin(), SplitPoint{0, 1});
+
+    Array<std::future<Chunk>> futures;
+    futures.reserve(points.size());
+
+    for (std::size_t i = 0; i < points.size(); i++) {
+        std::size_t begin = points[i].offset;
+        std::size_t end   = i + 1 < points.size() ? points[i + 1].offset : source.size();
+        StringView  slice = source.substr(begin, end - begin);
+
+        futures.push_back(
+            pool.queue_task([slice, &reader]() { return lex_chunk(slice, reader.file_name()); }));
+    }
+
+    // Stitch the chunks together
+    //  - the serial lexer desindents at the first token of the line following a chunk
+    //  - a chunk eof is only kept for the last chunk
+    //  - lines are relative to the chunk
+    Array<Token> tokens;
+    int32        indentation = 0;
+
+    for (std::size_t i = 0; i < futures.size(); i++) {
+        Chunk chunk  = futures[i].get();
+        int32 line   = points[i].line;
+        int32 offset = line - 1;
+        bool  last   = i + 1 == futures.size();
+
+        for (int32 k = 0; k < indentation / LYTHON_INDENT; k++) {
+            tokens.emplace_back(tok_desindent, line, 0);
+        }
+
+        tokens.reserve(tokens.size() + chunk.tokens.size());
+        for (Token const& tok: chunk.tokens) {
+            if (tok.type() == tok_eof && !last) {
+                break;
+            }
+            tokens.emplace_back(
+                tok.type(), tok.line() + offset, tok.col(), tok.identifier(), tok.operator_id());
+        }
+
+        indentation = chunk.indentation;
+    }
+
+    return tokens;
+}
+
+}  // namespace lython
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "dtypes.h"
+#include "lexer/buffer.h"
+#include "lexer/token.h"
+
+namespace lython {
+
+class ThreadPool;
+
+// Place where the source can be cut and lexed independently
+struct SplitPoint {
+    std::size_t offset;  // first character of the line
+    int32       line;    // line number of that character
+};
+
+// Find lines starting at indentation 0 with an identifier
+// outside of brackets, strings, docstrings and comments.
+// Chunks are at least chunk_size characters long
+Array<SplitPoint> find_split_points(StringView source, std::size_t chunk_size);
+
+// Lex the buffer on multiple threads, the token stream is the same as the serial Lexer.
+// Only in-memory buffers can be split, other buffers are lexed serially.
+// Tokens point inside the buffer which needs to outlive them; use ReplayLexer to parse them
+Array<Token> parallel_lex(AbstractBuffer& reader, ThreadPool& pool, std::size_t chunk_size = 1 << 16);
+
+}  // namespace lython
@@ -0,0 +1,194 @@
+#include "lexer/relex.h"
+#include "lexer/lexer.h"
+
+#include <algorithm>
+
+namespace lython {
+
+namespace {
+
+bool is_restart_char(char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_'; }
+
+bool is_multiline(int8 type) {
+    return type == tok_string || type == tok_docstring || type == tok_fstring;
+}
+
+// desindents and the newline ending the previous line carry the line of the next token
+bool is_line_prefix(int8 type) { return type == tok_newline || type == tok_desindent; }
+
+// Index of the first token of the line, tokens.size() if there is none
+std::size_t first_token_of_line(Array<Token> const& tokens, std::size_t start, int32 line) {
+    auto it = std::lower_bound(tokens.begin() + start, tokens.end(), line, [](Token const& tok, int32 l) {
+        return tok.line() < l;
+    });
+
+    while (it != tokens.end() && is_line_prefix(it->type())) {
+        it += 1;
+    }
+    return std::size_t(it - tokens.begin());
+}
+
+// A line starting with an identifier is a restart line if its first token starts on it,
+// i.e. the line is not the continuation of a string, and the previous line ended with a newline token.
+// The newline token resets _cindent to 0 and the desindents that follow bring _oindent down to 0
+bool is_restart_token(Array<Token> const& tokens, std::size_t index, int32 line) {
+    if (index >= tokens.size() || tokens[index].line() != line || is_multiline(tokens[index].type())) {
+        return false;
+    }
+
+    while (index > 0 && tokens[index - 1].type() == tok_desindent) {
+        index -= 1;
+    }
+    return index == 0 || tokens[index - 1].type() == tok_newline;
+}
+
+bool same_token(Token const& old_tok, Token const& new_tok, int32 line_delta) {
+    return old_tok.type() == new_tok.type() && old_tok.line() + line_delta == new_tok.line() &&
+           old_tok.col() == new_tok.col() && old_tok.operator_id() == new_tok.operator_id() &&
+           old_tok.identifier() == new_tok.identifier();
+}
+
+Token rebase(Token const& tok, StringView old_source, const char* new_base, int32 line_delta) {
+    StringView  text  = tok.identifier();
+    const char* begin = old_source.data();
+    const char* end   = begin + old_source.size();
+
+    if (text.data() != nullptr && text.data() >= begin && text.data() < end) {
+        text = StringView(new_base + (text.data() - begin), text.size());
+    }
+    return Token(tok.type(), tok.line() + line_delta, tok.col(), text, tok.operator_id());
+}
+
+}  // namespace
+
+TokenRange relex(Array<Token>& tokens, StringView old_source, StringView new_source, SourceEdit const& edit) {
+    std::size_t old_edit_end = edit.offset + edit.removed;
+    std::size_t new_edit_end = edit.offset + edit.text.size();
+    auto        delta        = std::ptrdiff_t(new_edit_end) - std::ptrdiff_t(old_edit_end);
+
+    int32 line_delta = int32(std::count(edit.text.begin(), edit.text.end(), '\n')) -
+                       int32(std::count(old_source.begin() + edit.offset,
+                                        old_source.begin() + old_edit_end,
+                                        '\n'));
+
+    // Find the restart line, walking back from the edit
+    // the first character of the line needs to be before the edit so it is unchanged
+    std::size_t restart      = 0;
+    int32       restart_line = 1;
+    std::size_t begin        = 0;
+    {
+        int32       line = 1 + int32(std::count(old_source.begin(), old_source.begin() + edit.offset, '\n'));
+        std::size_t pos  = old_source.rfind('\n', edit.offset == 0 ? 0 : edit.offset - 1);
+
+        while (pos != StringView::npos && line > 1) {
+            std::size_t start = pos + 1;
+
+            if (start < edit.offset && is_restart_char(old_source[start])) {
+                std::size_t index = first_token_of_line(tokens, 0, line);
+
+                if (is_restart_token(tokens, index, line)) {
+                    restart      = start;
+                    restart_line = line;
+                    begin        = index;
+                    break;
+                }
+            }
+
+            line -= 1;
+            pos = pos == 0 ? StringView::npos : old_source.rfind('\n', pos - 1);
+        }
+    }
+
+    // Relex until the streams resynchronize
+    ViewBuffer              reader(new_source.substr(restart), "<relex>");
+    BufferLexer<ViewBuffer> lex(reader);
+
+    Array<Token> lexed;
+    std::size_t  old_end = tokens.size();
+    bool         synced  = false;
+
+    // start of the line being checked for resynchronization in new_source
+    std::size_t line_start  = restart;
+    int32       line_number = restart_line;
+    int32       last_line   = restart_line;
+    int32       offset      = restart_line - 1;
+
+    for (Token tok = lex.next_token();; tok = lex.next_token()) {
+        int32 line = tok.line() + offset;
+        lexed.emplace_back(tok.type(), line, tok.col(), tok.identifier(), tok.operator_id());
+
+        if (tok.type() == tok_eof) {
+            break;
+        }
+
+        // only check the first token of each line
+        if (line <= last_line || is_line_prefix(tok.type())) {
+            continue;
+        }
+        last_line = line;
+
+        while (line_number < line && line_start != StringView::npos) {
+            line_start = new_source.find('\n', line_start);
+            line_start = line_start == StringView::npos ? line_start : line_start + 1;
+            line_number += 1;
+        }
+
+        if (line_start >= new_source.size() || line_start < new_edit_end ||
+            !is_restart_char(new_source[line_start]) || !is_restart_token(lexed, lexed.size() - 1, line)) {
+            continue;
+        }
+
+        // the same line needs to be a restart line in the previous stream
+        std::size_t old_start  = std::size_t(std::ptrdiff_t(line_start) - delta);
+        int32       old_line   = line - line_delta;
+        std::size_t index      = first_token_of_line(tokens, begin, old_line);
+        bool        line_begin = old_start == 0 || old_source[old_start - 1] == '\n';
+
+        if (line_begin && is_restart_token(tokens, index, old_line)) {
+            lexed.pop_back();
+            old_end = index;
+            synced  = true;
+            break;
+        }
+    }
+
+    // Narrow the range down to the tokens that changed
+    std::size_t prefix = 0;
+    std::size_t suffix = 0;
+    std::size_t common = std::min(lexed.size(), old_end - begin);
+
+    while (prefix < common && same_token(tokens[begin + prefix], lexed[prefix], 0)) {
+        prefix += 1;
+    }
+    while (prefix + suffix < common &&
+           same_token(tokens[old_end - 1 - suffix], lexed[lexed.size() - 1 - suffix], line_delta)) {
+        suffix += 1;
+    }
+
+    // Splice the new tokens in
+    Array<Token> result;
+    result.reserve(begin + lexed.size() + (tokens.size() - old_end));
+
+    for (std::size_t i = 0; i < begin; i++) {
+        result.push_back(rebase(tokens[i], old_source, new_source.data(), 0));
+    }
+
+    result.insert(result.end(), lexed.begin(), lexed.end());
+
+    if (synced) {
+        for (std::size_t i = old_end; i < tokens.size(); i++) {
+            result.push_back(rebase(tokens[i], old_source, new_source.data() + delta, line_delta));
+        }
+    }
+
+    TokenRange range;
+    range.begin      = begin + prefix;
+    range.old_end    = old_end - suffix;
+    range.new_end    = begin + lexed.size() - suffix;
+    range.line_delta = line_delta;
+
+    tokens = std::move(result);
+    return range;
+}
+
+}  // namespace lython
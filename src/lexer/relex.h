@@ -0,0 +1,35 @@
+#pragma once
+
+#include "dtypes.h"
+#include "lexer/token.h"
+
+namespace lython {
+
+// Characters [offset, offset + removed) of the source were replaced by text
+struct SourceEdit {
+    std::size_t offset  = 0;
+    std::size_t removed = 0;
+    StringView  text;
+};
+
+// Tokens [begin, old_end) of the previous stream were replaced by [begin, new_end),
+// the tokens that follow moved by line_delta lines
+struct TokenRange {
+    std::size_t begin      = 0;
+    std::size_t old_end    = 0;
+    std::size_t new_end    = 0;
+    int32       line_delta = 0;
+};
+
+// Update the tokens of old_source so they match new_source, which is old_source with the edit applied.
+//
+// Lexing restarts at the last line before the edit that starts a top level statement,
+// where the lexer has no pending indentation (_cindent == _oindent == 0) and is not inside a string.
+// It stops at the first such line after the edit that was also a restart line in the previous stream,
+// from there both streams are the same up to a line shift.
+// The relexed tokens that did not change are left out of the returned range.
+//
+// Unchanged tokens are rebased to point inside new_source which needs to outlive them
+TokenRange relex(Array<Token>& tokens, StringView old_source, StringView new_source, SourceEdit const& edit);
+
+}  // namespace lython
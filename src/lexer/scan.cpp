@@ -0,0 +1,207 @@
+#include "lexer/scan.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#    define LY_SCAN_X86 1
+#    include <immintrin.h>
+#else
+#    define LY_SCAN_X86 0
+#endif
+
+namespace lython {
+
+// Scalar
+// ------
+namespace {
+
+inline bool is_identifier(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+           c == '_' || c == '?' || c == '!' || c == '-';
+}
+
+const char* scalar_identifier(const char* begin, const char* end) {
+    while (begin < end && is_identifier(*begin)) {
+        begin += 1;
+    }
+    return begin;
+}
+
+const char* scalar_spaces(const char* begin, const char* end) {
+    while (begin < end && *begin == ' ') {
+        begin += 1;
+    }
+    return begin;
+}
+
+const char* scalar_line(const char* begin, const char* end) {
+    while (begin < end && *begin != '\n') {
+        begin += 1;
+    }
+    return begin;
+}
+
+const char* scalar_string(const char* begin, const char* end) {
+    while (begin < end && *begin != '"' && *begin != '\n') {
+        begin += 1;
+    }
+    return begin;
+}
+
+}  // namespace
+
+Scanners const& scalar_scanners() {
+    static Scanners scan{scalar_identifier, scalar_spaces, scalar_line, scalar_string, "scalar"};
+    return scan;
+}
+
+#if LY_SCAN_X86
+
+// SIMD
+// ----
+// Every block computes a bitmask of the characters that end the run,
+// the first set bit is the position we are looking for.
+// Bytes >= 0x80 are negative for the signed compares and never match a range.
+namespace {
+
+// SSE2
+#    define LY_SSE2 __attribute__((target("sse2")))
+
+LY_SSE2 inline __m128i sse2_in_range(__m128i v, char lo, char hi) {
+    return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(char(lo - 1))),
+                         _mm_cmpgt_epi8(_mm_set1_epi8(char(hi + 1)), v));
+}
+
+LY_SSE2 inline unsigned sse2_identifier_stop(__m128i v) {
+    __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+    __m128i match = _mm_or_si128(sse2_in_range(lower, 'a', 'z'), sse2_in_range(v, '0', '9'));
+    match         = _mm_or_si128(match, _mm_cmpeq_epi8(v, _mm_set1_epi8('_')));
+    match         = _mm_or_si128(match, _mm_cmpeq_epi8(v, _mm_set1_epi8('?')));
+    match         = _mm_or_si128(match, _mm_cmpeq_epi8(v, _mm_set1_epi8('!')));
+    match         = _mm_or_si128(match, _mm_cmpeq_epi8(v, _mm_set1_epi8('-')));
+    return ~unsigned(_mm_movemask_epi8(match)) & 0xFFFFu;
+}
+
+LY_SSE2 inline unsigned sse2_spaces_stop(__m128i v) {
+    return ~unsigned(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')))) & 0xFFFFu;
+}
+
+LY_SSE2 inline unsigned sse2_line_stop(__m128i v) {
+    return unsigned(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n'))));
+}
+
+LY_SSE2 inline unsigned sse2_string_stop(__m128i v) {
+    return unsigned(_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')),
+                                                   _mm_cmpeq_epi8(v, _mm_set1_epi8('\n')))));
+}
+
+#    define SSE2_SCANNER(name)                                                             \
+        LY_SSE2 const char* sse2_##name(const char* begin, const char* end) {             \
+            while (end - begin >= 16) {                                                    \
+                unsigned stop = sse2_##name##_stop(                                        \
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin)));             \
+                if (stop != 0) {                                                           \
+                    return begin + __builtin_ctz(stop);                                    \
+                }                                                                          \
+                begin += 16;                                                               \
+            }                                                                              \
+            return scalar_##name(begin, end);                                              \
+        }
+
+SSE2_SCANNER(identifier)
+SSE2_SCANNER(spaces)
+SSE2_SCANNER(line)
+SSE2_SCANNER(string)
+
+#    undef SSE2_SCANNER
+
+// AVX2
+#    define LY_AVX2 __attribute__((target("avx2")))
+
+LY_AVX2 inline __m256i avx2_in_range(__m256i v, char lo, char hi) {
+    return _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(char(lo - 1))),
+                            _mm256_cmpgt_epi8(_mm256_set1_epi8(char(hi + 1)), v));
+}
+
+LY_AVX2 inline unsigned avx2_identifier_stop(__m256i v) {
+    __m256i lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+    __m256i match = _mm256_or_si256(avx2_in_range(lower, 'a', 'z'), avx2_in_range(v, '0', '9'));
+    match         = _mm256_or_si256(match, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_')));
+    match         = _mm256_or_si256(match, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('?')));
+    match         = _mm256_or_si256(match, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('!')));
+    match         = _mm256_or_si256(match, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('-')));
+    return ~unsigned(_mm256_movemask_epi8(match));
+}
+
+LY_AVX2 inline unsigned avx2_spaces_stop(__m256i v) {
+    return ~unsigned(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' '))));
+}
+
+LY_AVX2 inline unsigned avx2_line_stop(__m256i v) {
+    return unsigned(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'))));
+}
+
+LY_AVX2 inline unsigned avx2_string_stop(__m256i v) {
+    return unsigned(
+        _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')),
+                                             _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')))));
+}
+
+// Short runs (most identifiers) are finished by the SSE2 version
+#    define AVX2_SCANNER(name)                                                             \
+        LY_AVX2 const char* avx2_##name(const char* begin, const char* end) {             \
+            while (end - begin >= 32) {                                                    \
+                unsigned stop = avx2_##name##_stop(                                        \
+                    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin)));          \
+                if (stop != 0) {                                                           \
+                    return begin + __builtin_ctz(stop);                                    \
+                }                                                                          \
+                begin += 32;                                                               \
+            }                                                                              \
+            return sse2_##name(begin, end);                                                \
+        }
+
+AVX2_SCANNER(identifier)
+AVX2_SCANNER(spaces)
+AVX2_SCANNER(line)
+AVX2_SCANNER(string)
+
+#    undef AVX2_SCANNER
+
+}  // namespace
+
+Scanners const* sse2_scanners() {
+    static Scanners scan{sse2_identifier, sse2_spaces, sse2_line, sse2_string, "sse2"};
+    if (__builtin_cpu_supports("sse2")) {
+        return &scan;
+    }
+    return nullptr;
+}
+
+Scanners const* avx2_scanners() {
+    static Scanners scan{avx2_identifier, avx2_spaces, avx2_line, avx2_string, "avx2"};
+    if (__builtin_cpu_supports("avx2")) {
+        return &scan;
+    }
+    return nullptr;
+}
+
+#else
+
+Scanners const* sse2_scanners() { return nullptr; }
+Scanners const* avx2_scanners() { return nullptr; }
+
+#endif
+
+Scanners const& scanners() {
+    static Scanners const& scan = []() -> Scanners const& {
+        if (Scanners const* avx2 = avx2_scanners()) {
+            return *avx2;
+        }
+        if (Scanners const* sse2 = sse2_scanners()) {
+            return *sse2;
+        }
+        return scalar_scanners();
+    }();
+    return scan;
+}
+
+}  // namespace lython
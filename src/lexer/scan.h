@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+
+namespace lython {
+
+/*
+ *  Character classification over runs of characters
+ *
+ *  Each scanner returns a pointer to the first character of [begin, end)
+ *  that does not belong to the run, or end if the whole range matched.
+ *
+ *  The implementation is selected once at startup depending on the CPU (AVX2, SSE2 or scalar)
+ *  scanners never read past end
+ */
+struct Scanners {
+    // [a-zA-Z0-9_?!-]
+    const char* (*identifier)(const char* begin, const char* end);
+
+    // ' '
+    const char* (*spaces)(const char* begin, const char* end);
+
+    // anything but '\n', used for comments
+    const char* (*line)(const char* begin, const char* end);
+
+    // anything but '"' and '\n', used for string bodies
+    // newlines are left to the buffer so it can keep track of the line number
+    const char* (*string)(const char* begin, const char* end);
+
+    const char* name;
+};
+
+Scanners const& scanners();
+
+// Implementations, exposed for testing
+Scanners const& scalar_scanners();
+Scanners const* sse2_scanners();  // null when not supported
+Scanners const* avx2_scanners();  // null when not supported
+
+}  // namespace lython
@@ -2,6 +2,8 @@
 #include "utilities/strings.h"
 #include <spdlog/fmt/bundled/core.h>
 
+#include <cstring>
+
 namespace lython {
 
 String to_string(int8 t) {
@@ -58,10 +60,37 @@ std::ostream& Token::debug_print(std::ostream& out) const {
 
     out << " =>"
         << " [l:" << fmt::format("{:4}", _line) << ", c:" << fmt::format("{:4}", _col) << "] `"
-        << _identifier << "`";
+        << identifier() << "`";
     return out;
 }
 
+namespace {
+// number tokens are not null terminated, copy them before handing them to the C parsers
+template <typename T, typename Fun>
+T parse_number(StringView text, Fun fun) {
+    char buffer[64];
+    auto size = std::min(text.size(), sizeof(buffer) - 1);
+
+    std::memcpy(buffer, text.data(), size);
+    buffer[size] = '\0';
+    return T(fun(buffer));
+}
+}  // namespace
+
+float64 Token::as_float() const {
+    return parse_number<float64>(identifier(), [](const char* str) { return std::strtod(str, nullptr); });
+}
+
+int64 Token::as_integer() const {
+    return parse_number<int64>(identifier(),
+                               [](const char* str) { return std::strtoll(str, nullptr, 10); });
+}
+
+uint64 Token::as_uint64() const {
+    return parse_number<uint64>(identifier(),
+                                [](const char* str) { return std::strtoull(str, nullptr, 10); });
+}
+
 std::ostream& Token::print(std::ostream& out) const {
 
     if (type() > 0) {
@@ -8,6 +8,7 @@
 
 #include "dtypes.h"
 #include "logging/logging.h"
+#include "utilities/names.h"
 
 /*
  *  incorrect is used when the input is known to be wrong
@@ -155,13 +156,25 @@ KeywordToString& keyword_as_string();
 
 int8 tok_name_size();
 
+// Tokens do not own their text, it points inside the source buffer
+// or inside the lexer for streamed buffers and static strings for operators.
+// A token is only valid as long as the lexer and its buffer are alive.
 class Token {
     public:
+    Token() = default;
+
     Token(TokenType t, int32 l, int32 c): _type(t), _line(l), _col(c) {}
 
     Token(int8 t, int32 l, int32 c): _type(t), _line(l), _col(c) {}
 
+    Token(int8 t, int32 l, int32 c, StringView text, int8 op = 0):
+        _type(t), _op(op), _line(l), _col(c), _size(uint32(text.size())), _text(text.data()) {}
+
     int8  type() const { return _type; }
+
+    // Index of the operator in operator_table, 0 if the token is not an operator
+    int8 operator_id() const { return _op; }
+
     int32 line() const { return _line; }
 
     int32 begin_col() const { return _col - int32(identifier().size()); }
@@ -171,15 +184,15 @@ class Token {
     int32 end_line() const { return col(); }
     int32 begin_line() const { return col() - int32(identifier().size()); }
 
-    String&       operator_name() { return _identifier; }
-    String const& operator_name() const { return _identifier; }
-    String&       identifier() { return _identifier; }
-    String const& identifier() const { return _identifier; }
+    StringView operator_name() const { return identifier(); }
+    StringView identifier() const { return StringView(_text, _size); }
 
-    float64 as_float() const { return std::stod(_identifier.c_str()); }
+    // Interned on demand, only names that end up in the AST need it
+    StringRef ref() const { return StringDatabase::instance().string(identifier()); }
 
-    int64  as_integer() const { return std::strtoll(_identifier.c_str(), nullptr, 10); }
-    uint64 as_uint64() const { return std::strtoull(_identifier.c_str(), nullptr, 10); }
+    float64 as_float() const;
+    int64   as_integer() const;
+    uint64  as_uint64() const;
 
     operator bool() const { return _type != tok_eof; }
 
@@ -199,11 +212,13 @@ class Token {
 
     private:
     int8  _type = tok_incorrect;
+    int8  _op   = 0;
     int32 _line = -1;
     int32 _col  = -1;
 
     // Data
-    String _identifier;
+    uint32      _size = 0;
+    const char* _text = nullptr;
 
     public:
     // print all tokens and their info
@@ -212,6 +227,8 @@ class Token {
     std::ostream& print(std::ostream& out) const;
 };
 
+static_assert(std::is_trivially_copyable<Token>::value, "Token should be cheap to copy");
+
 inline Token& dummy() {
     static Token dy = Token(tok_incorrect, 0, 0);
     return dy;
@@ -0,0 +1,179 @@
+#include "lexer/token_cache.h"
+#include "lexer/lexer.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+#ifdef __linux__
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <chrono>
+#include <thread>
+#endif
+
+namespace lython {
+
+uint64 source_hash(StringView source) { return uint64(xx_hash_3(source.data(), source.size())); }
+
+String token_cache_path(String const& cache_dir, uint64 hash) {
+    return String(fmt::format("{}/{:016x}.lytok", cache_dir, hash).c_str());
+}
+
+bool save_token_cache(String const&       path,
+                      uint64              hash,
+                      uint64              source_size,
+                      Array<Token> const& tokens) {
+    Array<TokenRecord>      records;
+    String                  text;
+    Dict<StringView, uint32> offsets;
+
+    records.reserve(tokens.size());
+
+    for (Token const& tok: tokens) {
+        StringView str    = tok.identifier();
+        uint32     offset = 0;
+
+        auto result = offsets.find(str);
+        if (result != offsets.end()) {
+            offset = result->second;
+        } else {
+            offset = uint32(text.size());
+            text.append(str.data(), str.size());
+            offsets[str] = offset;
+        }
+
+        TokenRecord record = {
+            offset, uint32(str.size()), tok.line(), tok.col(), tok.type(), tok.operator_id(), {0, 0}};
+        records.push_back(record);
+    }
+
+    TokenCacheHeader header = {{'L', 'Y', 'T', 'K'},
+                               token_cache_version,
+                               hash,
+                               source_size,
+                               uint32(records.size()),
+                               uint32(text.size())};
+
+    // every writer gets its own temporary file next to the cache entry
+    // so concurrent writers never interleave before the rename
+    FILE* file = nullptr;
+#ifdef __linux__
+    String tmp = path + ".XXXXXX";
+    int    fd  = mkstemp(tmp.data());
+    if (fd >= 0) {
+        // mkstemp creates the file 0600, keep the cache readable like fopen would
+        fchmod(fd, 0644);
+        file = fdopen(fd, "wb");
+        if (file == nullptr) {
+            close(fd);
+        }
+    }
+#else
+    String tmp = path + String(fmt::format(".{:x}.{:x}.tmp",
+                                           std::hash<std::thread::id>()(std::this_thread::get_id()),
+                                           std::chrono::steady_clock::now().time_since_epoch().count())
+                                   .c_str());
+    file = fopen(tmp.c_str(), "wb");
+#endif
+    if (file == nullptr) {
+        std::error_code err;
+        std::filesystem::remove(tmp.c_str(), err);
+        return false;
+    }
+
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    ok      = ok && fwrite(records.data(), sizeof(TokenRecord), records.size(), file) == records.size();
+    ok      = ok && fwrite(text.data(), 1, text.size(), file) == text.size();
+    ok      = (fclose(file) == 0) && ok;
+
+    std::error_code err;
+    if (ok) {
+        std::filesystem::rename(tmp.c_str(), path.c_str(), err);
+    }
+    if (!ok || err) {
+        std::filesystem::remove(tmp.c_str(), err);
+        return false;
+    }
+    return true;
+}
+
+TokenCache::TokenCache(AbstractBuffer& reader, String const& cache_dir) {
+    StringView source = reader.source();
+
+    // streamed buffers cannot be hashed before being read, lex them as usual
+    if (source.empty()) {
+        Lexer lex(reader);
+        _tokens = lex.extract_token();
+        return;
+    }
+
+    uint64 hash = reader.hash();
+    String path = token_cache_path(cache_dir, hash);
+
+    if (load(path, hash, source.size())) {
+        return;
+    }
+
+    Lexer lex(reader);
+    _tokens = lex.extract_token();
+
+    std::error_code err;
+    std::filesystem::create_directories(cache_dir.c_str(), err);
+    save_token_cache(path, hash, source.size(), _tokens);
+}
+
+bool TokenCache::load(String const& path, uint64 hash, uint64 source_size) {
+    std::error_code err;
+    if (!std::filesystem::is_regular_file(path.c_str(), err)) {
+        return false;
+    }
+
+    Unique<MappedFileBuffer> file = std::make_unique<MappedFileBuffer>(path);
+    StringView               data = file->source();
+
+    TokenCacheHeader header;
+    if (data.size() < sizeof(header)) {
+        return false;
+    }
+    std::memcpy(&header, data.data(), sizeof(header));
+
+    std::size_t expected_size = sizeof(header) + std::size_t(header.token_count) * sizeof(TokenRecord) +
+                                header.text_size;
+
+    if (std::memcmp(header.magic, "LYTK", 4) != 0 || header.version != token_cache_version ||
+        header.hash != hash || header.source_size != source_size || data.size() != expected_size) {
+        return false;
+    }
+
+    const char* records = data.data() + sizeof(header);
+    const char* text    = records + std::size_t(header.token_count) * sizeof(TokenRecord);
+
+    _tokens.clear();
+    _tokens.reserve(header.token_count);
+
+    for (uint32 i = 0; i < header.token_count; i++) {
+        TokenRecord record;
+        std::memcpy(&record, records + i * sizeof(TokenRecord), sizeof(TokenRecord));
+
+        bool valid_op = record.op >= 0 && record.op < operator_count;
+
+        if (std::size_t(record.offset) + record.size > header.text_size || !valid_op) {
+            _tokens.clear();
+            return false;
+        }
+
+        _tokens.emplace_back(record.type,
+                             record.line,
+                             record.col,
+                             StringView(text + record.offset, record.size),
+                             record.op);
+    }
+
+    _file = std::move(file);
+    return true;
+}
+
+}  // namespace lython
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "dtypes.h"
+#include "lexer/buffer.h"
+#include "lexer/token.h"
+
+namespace lython {
+
+/*
+ *  Binary token stream saved on disk so unchanged files do not need to be lexed again
+ *
+ *  Layout (native endianness)
+ *
+ *      TokenCacheHeader
+ *      TokenRecord[token_count]
+ *      char text[text_size]        deduplicated token text
+ *
+ *  The file is mapped in memory and the tokens point straight into the mapping
+ */
+struct TokenCacheHeader {
+    char   magic[4];     // LYTK
+    uint32 version;      //
+    uint64 hash;         // hash of the source the tokens were extracted from
+    uint64 source_size;  //
+    uint32 token_count;  //
+    uint32 text_size;    //
+};
+
+struct TokenRecord {
+    uint32 offset;  // text offset inside the text section
+    uint32 size;    //
+    int32  line;    //
+    int32  col;     //
+    int8   type;    //
+    int8   op;      // operator id
+    int8   padding[2];
+};
+
+static constexpr uint32 token_cache_version = 2;
+
+// Hash used to key the caches, same as AbstractBuffer::hash()
+uint64 source_hash(StringView source);
+
+// <cache_dir>/<hash>.lytok
+String token_cache_path(String const& cache_dir, uint64 hash);
+
+// Write the token stream, the file is written next to its destination and then renamed
+// so concurrent readers never see a partial file
+bool save_token_cache(String const& path, uint64 hash, uint64 source_size, Array<Token> const& tokens);
+
+// Tokens of a buffer, loaded from the cache directory when the source did not change.
+// Otherwise the buffer is lexed and the cache updated.
+// Tokens are valid as long as the cache and the buffer are alive
+class TokenCache {
+    public:
+    TokenCache(AbstractBuffer& reader, String const& cache_dir);
+
+    // true if the tokens were loaded from the disk
+    bool hit() const { return _file != nullptr; }
+
+    Array<Token>& tokens() { return _tokens; }
+
+    private:
+    bool load(String const& path, uint64 hash, uint64 source_size);
+
+    Unique<MappedFileBuffer> _file;
+    Array<Token>             _tokens;
+};
+
+}  // namespace lython
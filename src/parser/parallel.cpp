@@ -0,0 +1,182 @@
+#include "parser/parser.h"
+#include "utilities/pool.h"
+
+#include <algorithm>
+#include <exception>
+#include <future>
+
+namespace lython {
+
+namespace {
+
+// The pool copies the result of the tasks
+struct ParsedChunk {
+    Module*             module = nullptr;
+    Array<ParsingError> errors;
+    std::exception_ptr  failure;  // set if the chunk raised something else than a syntax error
+};
+
+ParsedChunk
+parse_chunk(Array<Token>& tokens, String const& file_name, bool lazy_bodies, bool throw_errors) {
+    ReplayLexer lex(tokens, file_name);
+    Parser      parser(lex);
+    parser.set_lazy_bodies(lazy_bodies);
+    parser.set_throw_errors(throw_errors);
+
+    ParsedChunk chunk;
+    try {
+        chunk.module = parser.parse_module();
+        chunk.errors = parser.get_errors();
+    } catch (...) {
+        delete chunk.module;
+        chunk.module  = nullptr;
+        chunk.failure = std::current_exception();
+    }
+    return chunk;
+}
+
+}  // namespace
+
+// Comments and decorators are kept with the statement that follows them,
+// so each chunk starts with a statement and the comments end up at the same place
+// in the module body
+Array<std::size_t> find_statement_splits(Array<Token> const& tokens, std::size_t chunk_size) {
+    Array<std::size_t> splits;
+
+    std::size_t last       = 0;
+    std::size_t group      = 0;
+    bool        in_group   = false;
+    bool        line_start = true;
+    int         level      = 0;
+    int         brackets   = 0;
+
+    for (std::size_t i = 0; i < tokens.size(); i++) {
+        int type = tokens[i].type();
+
+        if (line_start && level == 0 && brackets == 0 &&
+            !in(type, tok_indent, tok_desindent, tok_newline, tok_eof)) {
+
+            if (in(type, tok_comment, tok_decorator)) {
+                group    = in_group ? group : i;
+                in_group = true;
+            } else {
+                std::size_t start = in_group ? group : i;
+                in_group          = false;
+
+                if (start > 0 && start - last >= chunk_size) {
+                    splits.push_back(start);
+                    last = start;
+                }
+            }
+        }
+
+        switch (type) {
+        case tok_indent: level += 1; break;
+        case tok_desindent: level -= 1; break;
+        case tok_parens:
+        case tok_square:
+        case tok_curly: brackets += 1; break;
+        case ')':
+        case ']':
+        case '}': brackets = std::max(brackets - 1, 0); break;
+        }
+
+        // desindents are issued at the start of the line they close
+        line_start = in(type, tok_newline, tok_desindent) || (line_start && type == tok_indent);
+    }
+
+    return splits;
+}
+
+Module* Parser::parse_module(ThreadPool& pool, std::size_t chunk_size) {
+    // a single worker would only add overhead
+    if (pool.size() <= 1) {
+        return parse_module();
+    }
+
+    Array<Token> tokens;
+    tokens.push_back(token());
+    while (tokens.back().type() != tok_eof) {
+        tokens.push_back(_lex.next_token());
+    }
+
+    Array<std::size_t> splits = find_statement_splits(tokens, chunk_size);
+    splits.insert(splits.begin(), 0);
+
+    // chunk i goes from splits[i] to splits[i + 1]
+    Array<Array<Token>> slices;
+    slices.reserve(splits.size());
+
+    for (std::size_t i = 0; i < splits.size(); i++) {
+        std::size_t end = i + 1 < splits.size() ? splits[i + 1] : tokens.size();
+        slices.emplace_back(tokens.begin() + splits[i], tokens.begin() + end);
+    }
+
+    String const& file_name = _lex.file_name();
+    bool          lazy      = lazy_bodies;
+    bool          throws    = throw_errors;
+
+    Array<std::future<ParsedChunk>> futures;
+    futures.reserve(slices.size());
+
+    try {
+        for (Array<Token>& slice: slices) {
+            futures.push_back(pool.queue_task([&slice, &file_name, lazy, throws]() {
+                return parse_chunk(slice, file_name, lazy, throws);
+            }));
+        }
+    } catch (...) {
+        // the queued tasks still use the slices
+        for (auto& future: futures) {
+            delete future.get().module;
+        }
+        throw;
+    }
+
+    // the tasks use the slices, all of them need to be done before raising
+    Array<ParsedChunk> chunks;
+    chunks.reserve(futures.size());
+
+    std::exception_ptr failure;
+    for (auto& future: futures) {
+        chunks.push_back(future.get());
+        if (chunks.back().failure && !failure) {
+            failure = chunks.back().failure;
+        }
+    }
+
+    // own the chunks right away, nothing leaks whatever raises next
+    Array<Unique<Module>> parts(chunks.size());
+    for (std::size_t i = 0; i < chunks.size(); i++) {
+        parts[i].reset(chunks[i].module);
+    }
+
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+
+    // Merge the chunks in source order, the module keeps the arenas of the chunks alive
+    Unique<Module> module(new Module());
+    module->class_id = meta::type_id<Module>();
+    module->enable_arena();
+
+    for (std::size_t i = 0; i < chunks.size(); i++) {
+        Module* part = parts[i].get();
+
+        for (StmtNode* stmt: part->body) {
+            module->add_child(stmt);
+            module->body.push_back(stmt);
+        }
+        part->body.clear();
+        module->arenas.push_back(std::move(part->arena));
+
+        for (ParsingError& error: chunks[i].errors) {
+            errors.push_back(error);
+        }
+    }
+
+    current_error = int(errors.size()) - 1;
+    return module.release();
+}
+
+}  // namespace lython
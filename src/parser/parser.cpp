@@ -1,6 +1,7 @@
 #include "parser.h"
 #include "ast/magic.h"
 #include "ast/ops.h"
+#include "lexer/buffer.h"
 #include "utilities/guard.h"
 #include "utilities/strings.h"
 
@@ -35,16 +36,28 @@ ExprNode* not_implemented_expr(Node* parent) { return parent->new_object<NotImpl
 
 ExprNode* not_allowed_expr(Node* parent) { return parent->new_object<NotAllowedEpxr>(); }
 
+// Returned by the rules stopped by a syntax error,
+// the statement holding it is replaced by an InvalidStatement
+ExprNode* invalid_expr(Node* parent) { return parent->new_object<NotImplementedExpr>(); }
+
 void Parser::start_code_loc(CommonAttributes* target, Token tok) {
-    target->col_offset = tok.begin_col();
-    target->lineno     = tok.line();
+    target->set_start(tok.line(), tok.begin_col());
 }
+// the start column moves to the end of the last token, the printers underline it
 void Parser::end_code_loc(CommonAttributes* target, Token tok) {
-    target->col_offset = tok.end_col();
-    target->end_lineno = tok.line();
+    target->set_start(target->lineno(), tok.end_col());
+    target->set_end(tok.line());
 }
 
-#define PARSER_THROW(T, err) throw T(err.message)
+// Stop the rule at a syntax error, see Parser::set_throw_errors()
+// the value is returned when the parser does not throw
+#define PARSER_THROW(T, err, ...) \
+    do {                          \
+        if (unwind()) {           \
+            return __VA_ARGS__;   \
+        }                         \
+        throw T(err.message);     \
+    } while (0)
 
 // Helpers
 // ---------------------------------------------
@@ -76,16 +89,14 @@ void Parser::expect_token(int expected, bool eat, Node* wip_expression, CodeLoca
     return expect_tokens(Array<int>{expected}, eat, wip_expression, loc);
 }
 
-OpConfig const& Parser::get_operator_config(Token const& tok) const {
-    static OpConfig nothing;
-
-    Dict<String, OpConfig> const& confs = default_precedence();
+// operator ids used by the parser
+constexpr int8 op_pow   = operator_id("**");
+constexpr int8 op_star  = operator_id("*");
+constexpr int8 op_bitor = operator_id("|");
+constexpr int8 op_dot   = operator_id(".");
 
-    auto result = confs.find(tok.operator_name());
-    if (result == confs.end()) {
-        return nothing;
-    }
-    return result->second;
+OpConfig const& Parser::get_operator_config(Token const& tok) const {
+    return operator_table[tok.operator_id()].config;
 }
 
 bool Parser::is_binary_operator_family(OpConfig const& conf) {
@@ -166,7 +177,7 @@ Token Parser::parse_body(Node* parent, Array<StmtNode*>& out, int depth) {
             error_recovery(&error);
 
             InvalidStatement* stmt = parent->new_object<InvalidStatement>();
-            stmt->tokens           = error.line;
+            stmt->set_tokens(error.line());
             out.push_back(stmt);
             continue;
         }
@@ -188,32 +199,40 @@ Token Parser::parse_body(Node* parent, Array<StmtNode*>& out, int depth) {
             _pending_comments.clear();
         }
 
+        bool failed = false;
         try {
             auto stmt = parse_statement(parent, depth + 1);
 
             // only one liner should have the comment attached
-            if (stmt->is_one_line() && token().type() == tok_comment) {
+            if (!unwinding && stmt->is_one_line() && token().type() == tok_comment) {
                 stmt->comment = parse_comment(stmt, depth);
             }
 
-            if (!is_empty_line) {
+            if (!unwinding && !is_empty_line) {
                 // expects at least one newline to end the statement
                 // if not we do not know what this line is supposed to be
                 expect_tokens({tok_newline, tok_eof}, true, parent, LOC);
             }
 
-            if (stmt == nullptr) {
-                return token();
-            }
+            if (!unwinding) {
+                if (stmt == nullptr) {
+                    return token();
+                }
 
-            out.push_back(stmt);
+                out.push_back(stmt);
+            }
         } catch (ParsingException const&) {
-            //
+            failed = true;
+        }
+
+        // the statement failed, the tokens up to the end of the line are kept
+        if (failed || unwinding) {
+            unwinding           = false;
             ParsingError* error = &errors[current_error];
             error_recovery(error);
 
             InvalidStatement* stmt = parent->new_object<InvalidStatement>();
-            stmt->tokens           = error->line;
+            stmt->set_tokens(error->line());
             out.push_back(stmt);
         }
 
@@ -230,7 +249,7 @@ Token Parser::parse_body(Node* parent, Array<StmtNode*>& out, int depth) {
             "Expected a body"                //
         );
         add_wip_expr(error, parent);
-        PARSER_THROW(SyntaxError, error);
+        PARSER_THROW(SyntaxError, error, token());
     }
 
     auto last = token();
@@ -295,7 +314,7 @@ StmtNode* Parser::parse_function_def(Node* parent, bool async, int depth) {
 
     if (token().type() == tok_docstring) {
         Comment* comment   = nullptr;
-        String   docstring = token().identifier();
+        String   docstring(token().identifier());
 
         next_token();
         if (token().type() == tok_comment) {
@@ -306,7 +325,14 @@ StmtNode* Parser::parse_function_def(Node* parent, bool async, int depth) {
         expect_newline(stmt, LOC);
     }
 
-    auto last = parse_body(stmt, stmt->body, depth + 1);
+    Token last = dummy();
+    if (lazy_bodies && token().type() != tok_eof) {
+        stmt->lazy.async = async;
+        last             = skip_body(stmt, depth + 1);
+    } else {
+        last = parse_body(stmt, stmt->body, depth + 1);
+    }
+
     end_code_loc(stmt, last);
     async_mode.pop_back();
 
@@ -314,6 +340,78 @@ StmtNode* Parser::parse_function_def(Node* parent, bool async, int depth) {
     return stmt;
 }
 
+// Record the tokens of the block up to its closing desindent, nested blocks included
+Token Parser::skip_body(FunctionDef* fun, int depth) {
+    TRACE_START();
+
+    Array<Token> tokens;
+    int          level = 1;
+
+    while (token().type() != tok_eof) {
+        Token const& tok = token();
+        level += tok.type() == tok_indent;
+        level -= tok.type() == tok_desindent;
+
+        tokens.push_back(tok);
+        if (level == 0) {
+            break;
+        }
+        next_token();
+    }
+
+    auto last = token();
+    fun->lazy.set_tokens(tokens);
+
+    // eat the desindent
+    next_token();
+    return last;
+}
+
+bool Parser::parse_lazy_body(FunctionDef* fun) {
+    async_mode.push_back(fun->lazy.async);
+
+    try {
+        parse_body(fun, fun->body, 1);
+    } catch (ParsingException const&) {
+        // Expected a body, the error was recorded by parse_body
+    }
+    unwinding = false;
+
+    // comments at the end of the body are not followed by a statement
+    for (auto* comment: _pending_comments) {
+        fun->body.push_back(comment);
+    }
+    _pending_comments.clear();
+
+    async_mode.pop_back();
+    return !has_errors();
+}
+
+bool materialize(FunctionDef* fun, Array<ParsingError>* errors) {
+    if (!fun->lazy.pending()) {
+        return true;
+    }
+
+    // the lexer appends an eof token to the body, it is cleared right after
+    ReplayLexer lex(fun->lazy.tokens);
+    Parser      parser(lex);
+
+    bool ok = parser.parse_lazy_body(fun);
+    if (ok) {
+        fun->lazy.clear();
+        return true;
+    }
+
+    // the tokens of the errors point inside the text of the body, it stays with the function
+    if (errors != nullptr) {
+        for (ParsingError const& error: parser.get_errors()) {
+            errors->push_back(error);
+        }
+    }
+    fun->lazy.tokens.clear();
+    return false;
+}
+
 StmtNode* Parser::parse_class_def(Node* parent, int depth) {
     TRACE_START();
 
@@ -336,7 +434,7 @@ StmtNode* Parser::parse_class_def(Node* parent, int depth) {
 
     if (token().type() == tok_docstring) {
         Comment* comment   = nullptr;
-        String   docstring = token().identifier();
+        String   docstring(token().identifier());
         next_token();
 
         if (token().type() == tok_comment) {
@@ -361,7 +459,7 @@ StmtNode* Parser::parse_class_def(Node* parent, int depth) {
                 "Unsupported statement inside a classdef"  //
             );
             add_wip_expr(error, parent);
-            PARSER_THROW(SyntaxError, error);
+            PARSER_THROW(SyntaxError, error, stmt);
         }
     }
 
@@ -534,7 +632,7 @@ StmtNode* Parser::parse_if_alt(Node* parent, int depth) {
         expect_comment_or_newline(stmt, depth, LOC);
         expect_token(tok_indent, true, stmt, LOC);
 
-        auto last = parse_body(stmt, stmt->body, depth + 1);
+        parse_body(stmt, stmt->body, depth + 1);
     }
 
     while (token().type() == tok_elif) {
@@ -713,9 +811,9 @@ Pattern* Parser::parse_match_mapping(Node* parent, int depth) {
 
     while (token().type() != '}') {
 
-        if (token().operator_name() == "**") {
+        if (token().operator_id() == op_pow) {
             next_token();
-            pat->rest = token().identifier();
+            pat->rest = token().ref();
             expect_token(tok_identifier, true, pat, LOC);
             break;
         }
@@ -750,7 +848,7 @@ Pattern* Parser::parse_match_or(Node* parent, Pattern* child, int depth) {
     // TODO: this is the loc of '|' not the start of the expression
     start_code_loc(pat, token());
 
-    if (token().operator_name() != "|") {
+    if (token().operator_id() != op_bitor) {
         error("Unexpected operator {}", token().operator_name());
     }
 
@@ -760,7 +858,7 @@ Pattern* Parser::parse_match_or(Node* parent, Pattern* child, int depth) {
         child = parse_pattern(pat, depth + 1);
         pat->patterns.push_back(child);
 
-        if (token().type() == tok_operator && token().operator_name() == "|") {
+        if (token().type() == tok_operator && token().operator_id() == op_bitor) {
             next_token();
         } else {
             // could be ":" or "if"
@@ -802,7 +900,7 @@ Pattern* Parser::parse_pattern_1(Node* parent, int depth) {
 
     case tok_operator:
     case tok_star:
-        if (token().operator_name() == "**" || token().operator_name() == "*") {
+        if (token().operator_id() == op_pow || token().operator_id() == op_star) {
             return parse_match_star(parent, depth);
         }
 
@@ -854,7 +952,7 @@ Pattern* Parser::parse_pattern(Node* parent, int depth) {
     switch (token().type()) {
     case tok_operator:
     case '|':
-        if (token().operator_name() == "|") {
+        if (token().operator_id() == op_bitor) {
             return parse_match_or(parent, primary, depth);
         }
 
@@ -963,7 +1061,7 @@ StmtNode* Parser::parse_with(Node* parent, int depth) {
     expect_comment_or_newline(stmt, depth, LOC);
     expect_token(tok_indent, true, stmt, LOC);
 
-    auto last = parse_body(stmt, stmt->body, depth + 1);
+    parse_body(stmt, stmt->body, depth + 1);
     end_code_loc(stmt, token());
 
     return stmt;
@@ -1037,7 +1135,7 @@ StmtNode* Parser::parse_try(Node* parent, int depth) {
     expect_comment_or_newline(stmt, depth, LOC);
     expect_token(tok_indent, true, stmt, LOC);
 
-    auto last = parse_body(stmt, stmt->body, depth + 1);
+    parse_body(stmt, stmt->body, depth + 1);
 
     expect_token(tok_except, false, stmt, LOC);
     parse_except_handler(stmt, stmt->handlers, depth + 1);
@@ -1089,7 +1187,7 @@ StmtNode* Parser::parse_assert(Node* parent, int depth) {
 }
 
 bool is_dot(Token const& tok) {
-    return (tok.type() == tok_operator && tok.operator_name() == ".") || tok.type() == tok_dot;
+    return (tok.type() == tok_operator && tok.operator_id() == op_dot) || tok.type() == tok_dot;
 }
 
 String Parser::parse_module_path(Node* parent, int& level, int depth) {
@@ -1109,7 +1207,7 @@ String Parser::parse_module_path(Node* parent, int& level, int depth) {
 
         // module name
         if (token().type() == tok_identifier) {
-            path.push_back(get_identifier());
+            path.push_back(String(token().identifier()));
             next_token();
         }
 
@@ -1125,7 +1223,7 @@ String Parser::parse_module_path(Node* parent, int& level, int depth) {
                     "expect name after ."            //
                 );
                 add_wip_expr(error, parent);
-                PARSER_THROW(SyntaxError, error);
+                PARSER_THROW(SyntaxError, error, String());
             }
         }
 
@@ -1436,22 +1534,22 @@ ExprNode* Parser::parse_name(Node* parent, int depth) {
 #define LY_INT8_MAX  sizeof("255") / sizeof(char)
 
 bool Parser::is_valid_value() {
-    String const& value    = token().identifier();
-    int           has_sign = value[0] == '-' || value[0] == '+';
+    StringView value    = token().identifier();
+    int        has_sign = !value.empty() && (value[0] == '-' || value[0] == '+');
 
     switch (token().type()) {
     case tok_string: {
         return true;
     }
     case tok_int: {
-        if (value.size() > 18 + has_sign) {
+        if (value.size() > std::size_t(18 + has_sign)) {
             return false;
         }
         return true;
     }
     case tok_float: {
         // Max numbers of digits
-        if (value.size() > 16 + has_sign) {
+        if (value.size() > std::size_t(16 + has_sign)) {
             return false;
         }
         return true;
@@ -1472,13 +1570,13 @@ ConstantValue Parser::get_value(Node* parent) {
             "Value is out of range"          //
         );
         add_wip_expr(error, parent);
-        PARSER_THROW(SyntaxError, error);
+        PARSER_THROW(SyntaxError, error, ConstantValue());
     }
 
     switch (token().type()) {
 
     case tok_string: {
-        return ConstantValue(token().identifier());
+        return ConstantValue(String(token().identifier()));
     }
     case tok_int: {
         // FIXME handle different sizes
@@ -1575,10 +1673,10 @@ ExprNode* Parser::parse_yield_from(Node* parent, int depth) {
     return expr;
 }
 
-bool is_star(Token const& tok) { return tok.type() == tok_operator && tok.operator_name() == "*"; }
+bool is_star(Token const& tok) { return tok.type() == tok_operator && tok.operator_id() == op_star; }
 
 bool is_starstar(Token const& tok) {
-    return tok.type() == tok_operator && tok.operator_name() == "**";
+    return tok.type() == tok_operator && tok.operator_id() == op_pow;
 }
 
 Arguments Parser::parse_arguments(Node* parent, char kind, int depth) {
@@ -1589,7 +1687,8 @@ Arguments Parser::parse_arguments(Node* parent, char kind, int depth) {
 
     bool keywords = false;
 
-    while (token().type() != kind) {
+    // without exceptions the loop stops on the error
+    while (token().type() != kind && !unwinding) {
         ExprNode* value = nullptr;
 
         Arg arg;
@@ -1684,7 +1783,7 @@ void Parser::parse_comprehension(Node* parent, Array<Comprehension>& out, char k
 
     PopGuard _(parsing_context, ParsingContext::Comprehension);
 
-    while (token().type() != kind) {
+    while (token().type() != kind && !unwinding) {
         expect_token(tok_for, true, parent, LOC);
         Comprehension cmp;
 
@@ -1844,7 +1943,10 @@ parse_comprehension_or_literal(Parser* parser, Node* parent, int tok, char kind,
             "Comprehension is null"                  //
         );
         add_wip_expr(error, parent);
-        PARSER_THROW(SyntaxError, error);
+        if (parser->unwind()) {
+            return invalid_expr(parent);
+        }
+        throw SyntaxError(error.message);
     }
 
     // fix the things we could not do at the begining
@@ -1943,7 +2045,7 @@ ExprNode* Parser::parse_prefix_unary(Node* parent, int depth) {
 
     auto conf = get_operator_config(token());
 
-    if (token().operator_name() == "*") {
+    if (token().operator_id() == op_star) {
         return parse_starred(parent, depth);
     }
 
@@ -1955,7 +2057,7 @@ ExprNode* Parser::parse_prefix_unary(Node* parent, int depth) {
                    str(token())));
 
         add_wip_expr(error, parent);
-        PARSER_THROW(SyntaxError, error);
+        PARSER_THROW(SyntaxError, error, expr);
     }
 
     next_token();
@@ -1978,8 +2080,7 @@ Token Parser::parse_call_args(Node*             expr,
 
         // if not in keyword mode check if next argument is one
         if (keyword == false) {
-            auto lookahead = _lex.peek_token();
-            if (token().type() == tok_identifier && lookahead.type() == tok_assign) {
+            if (token().type() == tok_identifier && peek_token().type() == tok_assign) {
                 keyword = true;
             }
         }
@@ -2087,7 +2188,7 @@ ExprNode* Parser::parse_subscript(Node* parent, ExprNode* primary, int depth) {
             "Substript needs at least one argument"  //
         );
         add_wip_expr(error, parent);
-        PARSER_THROW(SyntaxError, error);
+        PARSER_THROW(SyntaxError, error, expr);
     }
 
     if (elts.size() == 1) {
@@ -2104,16 +2205,61 @@ ExprNode* Parser::parse_subscript(Node* parent, ExprNode* primary, int depth) {
     return expr;
 }
 
+std::shared_ptr<ErrorLine> TokenBuffer::line(Token const& end) const {
+    auto out = std::make_shared<ErrorLine>();
+    out->tokens.reserve(size);
+
+    if (source != nullptr) {
+        // eof is repeated when the parser reads past the end
+        for (std::size_t k = begin; k < begin + size; k++) {
+            out->tokens.push_back((*source)[std::min(k, source->size() - 1)]);
+        }
+        return out;
+    }
+
+    out->tokens = structure;
+    if (first < 0) {
+        return out;
+    }
+
+    // the tokens point inside the text of the line, it is kept with them
+    out->text = lexer.getline(first, std::max(last, end.line()));
+
+    ViewBuffer   reader(out->text, lexer.file_name());
+    Lexer        lex(reader);
+    Array<Token> tokens = lex.extract_token();
+
+    std::size_t k = 0;
+    while (k < tokens.size() && in(tokens[k].type(), tok_indent, tok_desindent)) {
+        k += 1;
+    }
+
+    for (; k < tokens.size() && out->tokens.size() < size; k++) {
+        Token const& tok = tokens[k];
+        out->tokens.emplace_back(
+            tok.type(), tok.line() + first - 1, tok.col(), tok.identifier(), tok.operator_id());
+    }
+
+    // the parser read past the end of the input
+    while (!out->tokens.empty() && out->tokens.size() < size) {
+        out->tokens.push_back(out->tokens.back());
+    }
+    return out;
+}
+
 void Parser::error_recovery(ParsingError* error) {
+    std::size_t eaten = 0;
     while (!in(token().type(), tok_newline, tok_eof)) {
-        error->remaining.push_back(token());
+        eaten += 1;
         next_token();
     }
-    error->line = currentline.tokens;
+    error->source_line     = currentline.line(token());
+    error->remaining_count = eaten;
 
-    if (error->line.size() > 0) {
-        Token const& start = error->line[0];
-        Token const& end   = error->line[int(error->line.size() - 1)];
+    Array<Token> const& line = error->line();
+    if (line.size() > 0) {
+        Token const& start = line[0];
+        Token const& end   = line[int(line.size() - 1)];
 
         // then we got a new line
         if (!error->received_token.isbetween(start, end)) {
@@ -2134,7 +2280,7 @@ ExprNode* Parser::parse_slice(Node* parent, ExprNode* primary, int depth) {
             "Slice is not allowed in this context"  //
         );
         add_wip_expr(error, primary);
-        PARSER_THROW(SyntaxError, error);
+        PARSER_THROW(SyntaxError, error, primary);
 
         // fallback to primary
         return primary;
@@ -2257,7 +2403,7 @@ StmtNode* Parser::parse_statement_primary(Node* parent, int depth) {
                    )                                                 //
         );
         add_wip_expr(error, parent);
-        PARSER_THROW(SyntaxError, error);
+        PARSER_THROW(SyntaxError, error, parent->new_object<InvalidStatement>());
     } else {
         previous = token();
     }
@@ -2419,7 +2565,7 @@ ExprNode* Parser::parse_operators(Node* og_parent, ExprNode* lhs, int min_preced
                         fmtstr("Unable to parse comparators")  //
                     );
                     add_wip_expr(err, parent);
-                    PARSER_THROW(SyntaxError, err);
+                    PARSER_THROW(SyntaxError, err, lhs);
                 }
             } else {
                 comp       = parent->new_object<Compare>();
@@ -2616,7 +2762,7 @@ ExprNode* Parser::parse_expression_primary(Node* parent, int depth) {
         "Expected an expression"  //
     );
     add_wip_expr(error, parent);
-    PARSER_THROW(SyntaxError, error);
+    PARSER_THROW(SyntaxError, error, invalid_expr(parent));
 }
 
 ExprNode* Parser::parse_expression_1(
@@ -2668,6 +2814,10 @@ ExprNode* Parser::parse_expression_1(
 }
 
 Token const& Parser::next_token() {
+    if (unwinding) {
+        return stopped;
+    }
+
     // add current token to the line and fetch next one
     COZ_BEGIN("T::Lexer::next_token");
 
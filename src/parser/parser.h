@@ -5,6 +5,7 @@
 #include "ast/nodes.h"
 #include "dependencies/coz_wrap.h"
 #include "lexer/lexer.h"
+#include "lexer/relex.h"
 #include "logging/logging.h"
 #include "parser/parsing_error.h"
 #include "utilities/metadata.h"
@@ -14,6 +15,8 @@
 
 namespace lython {
 
+class ThreadPool;
+
 enum class ParsingContext
 {
     None,
@@ -21,20 +24,49 @@ enum class ParsingContext
     Slice,
 };
 
-/* Saves all the token that makes up for the current line
+/* Tracks the tokens that make up the current line
  * this is used for printing better error message
+ *
+ * Only the range of the line is recorded, the tokens are built when an error needs them.
+ * When the lexer keeps its tokens in memory they are copied,
+ * tokens of streaming lexers cannot be read back, their source lines are lexed again
  */
 struct TokenBuffer {
+    TokenBuffer(AbstractLexer& lex): lexer(lex), source(lex.tokens()), begin(lex.index()) {}
 
     void add(Token const& tok) {
         if (tok.type() == tok_newline) {
-            tokens.clear();
+            begin += size + 1;
+            size  = 0;
+            first = -1;
+            structure.clear();
+            return;
+        }
+
+        // the indentation tokens depend on the previous lines, they cannot be lexed again
+        if (source == nullptr && size == structure.size() &&
+            in(tok.type(), tok_indent, tok_desindent)) {
+            structure.push_back(tok);
+        } else if (first < 0) {
+            first = tok.line();
+            last  = tok.line();
         } else {
-            tokens.push_back(tok);
+            last = std::max(last, tok.line());
         }
+
+        size += 1;
     }
 
-    Array<Token> tokens;
+    // Tokens of the line, end is the token that stopped the line
+    std::shared_ptr<ErrorLine> line(Token const& end) const;
+
+    AbstractLexer&      lexer;
+    Array<Token> const* source;
+    std::size_t         begin;
+    std::size_t         size  = 0;
+    int                 first = -1;  // source lines of the tokens
+    int                 last  = -1;
+    Array<Token>        structure;
 };
 
 /**
@@ -52,10 +84,16 @@ struct TokenBuffer {
  */
 class Parser {
     public:
-    Parser(AbstractLexer& lexer): _lex(lexer) { metadata_init_names(); }
+    Parser(AbstractLexer& lexer): currentline(lexer), _lex(lexer) { metadata_init_names(); }
 
     ParsingError&
     parser_error(lython::CodeLocation const& loc, String const& exception, String const& msg) {
+        // the statement already failed, only its first error is reported
+        if (unwinding) {
+            discarded = ParsingError();
+            return discarded;
+        }
+
         current_error += 1;
         assert(current_error == errors.size(), "Only one error at a time can happen");
 
@@ -71,6 +109,19 @@ class Parser {
 
     bool has_errors() const { return errors.size() > 0; }
 
+    // Skip the bodies of functions, only their signature and docstring are parsed.
+    // The tokens of the bodies are kept, see materialize()
+    void set_lazy_bodies(bool enabled) { lazy_bodies = enabled; }
+
+    // Parse the skipped body of a function, the lexer replays the body tokens
+    bool parse_lazy_body(FunctionDef* fun);
+
+    // Syntax errors unwind to the enclosing block by throwing a SyntaxError (default),
+    // or by returning: the parser stops at the error, its rules return what they built so far
+    // and the block recovers once it gets the control back.
+    // Both report the same errors, returning is cheaper on code with many errors
+    void set_throw_errors(bool enabled) { throw_errors = enabled; }
+
     void parse_to_module(Module* module) {
         // lookup the module
 
@@ -82,18 +133,32 @@ class Parser {
             // and raised to reach the parent block
             // this is the top level block no need to go further up
         }
+        unwinding = false;
     }
 
     Module* parse_module() {
         // lookup the module
         Module* module   = new Module();
         module->class_id = meta::type_id<Module>();
+        module->enable_arena();
 
         parse_to_module(module);
         return module;
     }
 
+    // Parse the module on multiple threads, the top-level statements are split
+    // in groups of at least chunk_size tokens and each group is parsed into its own arena.
+    // The module and the errors are the same as the serial parse_module()
+    Module* parse_module(ThreadPool& pool, std::size_t chunk_size = 1 << 12);
+
+    // Update a module after an edit, tokens is the stream updated by relex() and range what it changed.
+    // Only the statements holding the changed tokens are parsed again, in the innermost function
+    // or class body holding all of them; they replace the previous ones in that body or Module::body.
+    // The other nodes and their arenas are kept, the ones after the edit move by range.line_delta
+    void reparse(Module* mod, Array<Token>& tokens, TokenRange const& range);
+
     Token  parse_body(Node* parent, Array<StmtNode*>& out, int depth);
+    Token  skip_body(FunctionDef* fun, int depth);
     Token  parse_except_handler(Try* parent, Array<ExceptHandler>& out, int depth);
     void   parse_alias(Node* parent, Array<Alias>& out, int depth);
     Token  parse_match_case(Node* parent, Array<MatchCase>& out, int depth);
@@ -249,15 +314,23 @@ class Parser {
 
     // Shortcuts
     // ---------
+    // While unwinding the parser sees the end of the file, the lexer stays on the error
     Token const& next_token();
-    Token const& token() const { return _lex.token(); }
-    Token const& peek_token() const { return _lex.peek_token(); }
+    Token const& token() const { return unwinding ? stopped : _lex.token(); }
+    Token const& peek_token() const { return unwinding ? stopped : _lex.peek_token(); }
+    Token const& peek(int k) const { return unwinding ? stopped : _lex.peek(k); }
+
+    // Called at a syntax error, returns true if the rule should return instead of throwing
+    bool unwind() {
+        unwinding = !throw_errors;
+        return unwinding;
+    }
 
-    String get_identifier() const {
+    Identifier get_identifier() const {
         if (token().type() == tok_identifier) {
-            return token().identifier();
+            return token().ref();
         }
-        return String("<identifier>");
+        return Identifier(String("<identifier>"));
     }
 
     bool async() const {
@@ -308,6 +381,8 @@ class Parser {
     private:
     Array<StmtNode*>      _pending_comments;
     bool                  with_extension = true;
+    bool                  lazy_bodies    = false;
+    bool                  throw_errors   = true;
     Array<ExprContext>    _context;
     Array<bool>           async_mode;
     Array<ParsingContext> parsing_context;
@@ -316,7 +391,21 @@ class Parser {
     bool                is_empty_line = true;
     int                 current_error = -1;
     Array<ParsingError> errors;
+
+    // a syntax error is going up to the enclosing block, see set_throw_errors()
+    bool         unwinding = false;
+    Token        stopped   = Token(tok_eof, 0, 0);
+    ParsingError discarded;
 };
 
+// Parse the body of a function skipped by a lazy parser,
+// sema and the evaluator call it before looking at a body.
+// Returns false if the body had syntax errors, they are appended to errors
+bool materialize(FunctionDef* fun, Array<ParsingError>* errors = nullptr);
+
+// Indices of the top-level statements where a token stream can be parsed independently.
+// Chunks are at least chunk_size tokens long
+Array<std::size_t> find_statement_splits(Array<Token> const& tokens, std::size_t chunk_size);
+
 }  // namespace lython
 #endif
@@ -18,6 +18,17 @@ ParsingError::ParsingError(Array<int> expected, Token token, Node* obj, CodeLoca
     }
 }
 
+Array<Token> const& ParsingError::line() const {
+    static Array<Token> empty;
+    return source_line != nullptr ? source_line->tokens : empty;
+}
+
+Array<Token> ParsingError::remaining() const {
+    Array<Token> const& tokens = line();
+    std::size_t         count  = std::min(remaining_count, tokens.size());
+    return Array<Token>(tokens.end() - count, tokens.end());
+}
+
 void add_wip_expr(ParsingError& err, StmtNode* stmt) { err.stmt = stmt; }
 
 void add_wip_expr(ParsingError& err, ExprNode* expr) { err.expr = expr; }
@@ -130,9 +141,9 @@ void ParsingErrorPrinter::print_ast(ParsingError const& error,
         }
 
         // Print the tokens that we were not able to parse
-        if (error.remaining.size() > 0) {
+        if (error.remaining_count > 0) {
             Unlex unlex;
-            unlex.format(out, error.remaining);
+            unlex.format(out, error.remaining());
             written = true;
         }
 
@@ -151,7 +162,7 @@ void ParsingErrorPrinter::print_tok(ParsingError const& error, CommonAttributes*
     Unlex unlex;
 
     codeline();
-    unlex.format(out, error.line);
+    unlex.format(out, error.line());
 
     // Underline error if possible
     underline(error.received_token);
@@ -203,11 +214,11 @@ void ParsingErrorPrinter::underline(CommonAttributes const& attr) {
 
     int32 size = 1;
 
-    if (attr.end_col_offset.has_value()) {
-        size = std::max(attr.end_col_offset.value() - attr.col_offset, 1);
+    if (attr.end_col_offset().has_value()) {
+        size = std::max(attr.end_col_offset().value() - attr.col_offset(), 1);
     }
 
-    int32 start = std::max(1, attr.col_offset);
+    int32 start = std::max(1, attr.col_offset());
     codeline() << String(start, ' ') << String(size, '^');
 }
 
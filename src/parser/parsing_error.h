@@ -5,8 +5,16 @@
 #include "ast/nodes.h"
 #include "lexer/token.h"
 
+#include <memory>
+
 namespace lython {
 
+// Tokens of the line of an error, text owns their identifiers when they were lexed again
+struct ErrorLine {
+    Array<Token> tokens;
+    String       text;
+};
+
 struct ParsingError {
     Array<int>   expected_tokens;
     Token        received_token;
@@ -16,16 +24,22 @@ struct ParsingError {
     String       error_kind;
     String       message;
     CodeLocation loc;
-    Array<Token> remaining;  // Remaining token we have eaten to recover
-                             // in practice we just eat all tokens until next line
 
-    Array<Token> line;  // Line as a stream of tokens
+    // Line as a stream of tokens, shared by the copies of the error.
+    // The last remaining_count tokens were eaten to recover,
+    // in practice we just eat all tokens until next line
+    std::shared_ptr<ErrorLine const> source_line;
+    std::size_t                      remaining_count = 0;
+
     ParsingError(): received_token(dummy()), loc(LOC) {}
 
     ParsingError(Array<int> expected, Token token, CodeLocation loc_):
         expected_tokens(expected), received_token(token), loc(loc_) {}
 
     ParsingError(Array<int> expected, Token token, Node* obj, CodeLocation loc);
+
+    Array<Token> const& line() const;
+    Array<Token>        remaining() const;
 };
 
 class ParsingException: public LythonException {
@@ -0,0 +1,527 @@
+#include "parser/precompiled.h"
+#include "ast/fields.h"
+#include "lexer/buffer.h"
+#include "parser/parser.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <type_traits>
+
+namespace lython {
+
+namespace {
+
+// Pointer fields can only hold nodes of their family or of their exact kind
+template <typename T>
+bool compatible(Node* n) {
+    if constexpr (std::is_same_v<T, ExprNode>) {
+        return n->family() == NodeFamily::Expression;
+    } else if constexpr (std::is_same_v<T, StmtNode>) {
+        return n->family() == NodeFamily::Statement;
+    } else if constexpr (std::is_same_v<T, Pattern>) {
+        return n->family() == NodeFamily::Pattern;
+    } else {
+        return n->kind == nodekind<T>();
+    }
+}
+
+// Values used to grow the arrays while reading
+template <typename T>
+T blank() {
+    return T();
+}
+
+template <>
+Decorator blank<Decorator>() {
+    return Decorator(nullptr);
+}
+
+template <>
+Docstring blank<Docstring>() {
+    return Docstring("");
+}
+
+template <>
+Token blank<Token>() {
+    return dummy();
+}
+
+// Writer
+// ------
+class ModuleWriter {
+    public:
+    static constexpr bool loading = false;
+
+    ModuleWriter(Array<ParsingError>* errors): _errors(errors) {}
+
+    // false if a lazily skipped body had syntax errors
+    bool ok() const { return _ok; }
+
+    template <typename T>
+    void operator()(T& value) {
+        if constexpr (std::is_arithmetic_v<T> || std::is_enum_v<T>) {
+            data.append(reinterpret_cast<const char*>(&value), sizeof(T));
+        } else {
+            fields(*this, value);
+        }
+    }
+
+    template <typename T>
+    void operator()(T*& node) {
+        int8 kind = node == nullptr ? int8(NodeKind::Invalid) : int8(node->kind);
+        (*this)(kind);
+
+        if (node != nullptr) {
+            write_node(node);
+        }
+    }
+
+    template <typename T>
+    void operator()(Optional<T>& value) {
+        bool has_value = value.has_value();
+        (*this)(has_value);
+
+        if (has_value) {
+            (*this)(value.value());
+        }
+    }
+
+    template <typename T>
+    void operator()(Array<T>& values) {
+        uint32 size = uint32(values.size());
+        (*this)(size);
+
+        for (T& value: values) {
+            (*this)(value);
+        }
+    }
+
+    void operator()(String& value) { string(value); }
+
+    void operator()(StringRef& value) { string(StringView(value)); }
+
+    void operator()(Token& tok) {
+        int8  type = tok.type();
+        int8  op   = tok.operator_id();
+        int32 line = tok.line();
+        int32 col  = tok.col();
+
+        (*this)(type);
+        (*this)(op);
+        (*this)(line);
+        (*this)(col);
+        string(tok.identifier());
+    }
+
+    void operator()(ConstantValue& value) {
+        int8 type = int8(value.type());
+
+        // native objects only exist at runtime
+        if (value.type() == ConstantValue::TObject) {
+            type = int8(ConstantValue::TInvalid);
+        }
+        (*this)(type);
+
+        // clang-format off
+        switch (ConstantValue::Type(type)) {
+        #define POD(k, type, name) case ConstantValue::T##k: pod(value.get<type>()); break;
+        #define CPX(k, type, name) case ConstantValue::T##k: string(value.get<type>()); break;
+
+        NUMERIC_CONSTANT(POD)
+        CPX(String, String, string)
+
+        #undef CPX
+        #undef POD
+        default: break;
+        }
+        // clang-format on
+    }
+
+    String result(uint64 hash, uint64 source_size) const {
+        ModuleFileHeader header = {{'L', 'Y', 'C', 'M'},
+                                   module_file_version,
+                                   hash,
+                                   source_size,
+                                   uint32(records.size()),
+                                   uint32(data.size()),
+                                   uint32(text.size()),
+                                   0};
+
+        String out;
+        out.reserve(sizeof(header) + records.size() * sizeof(StringRecord) + data.size() +
+                    text.size());
+
+        out.append(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.append(reinterpret_cast<const char*>(records.data()),
+                   records.size() * sizeof(StringRecord));
+        out.append(data);
+        out.append(text);
+        return out;
+    }
+
+    private:
+    template <typename T>
+    void pod(T const& value) {
+        data.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    void string(StringView str) {
+        uint32 index = 0;
+
+        auto result = indices.find(str);
+        if (result != indices.end()) {
+            index = result->second;
+        } else {
+            index = uint32(records.size());
+            records.push_back({uint32(text.size()), uint32(str.size())});
+            text.append(str.data(), str.size());
+
+            // the key needs to outlive the writer
+            indices[StringView(text_keys.emplace_back(str))] = index;
+        }
+
+        pod(index);
+    }
+
+    template <typename T>
+    void write_node(T* node) {
+        if constexpr (std::is_base_of_v<T, FunctionDef>) {
+            if (node->kind == NodeKind::FunctionDef) {
+                FunctionDef* fun = static_cast<FunctionDef*>(node);
+
+                // bodies that failed to parse, now or before, hold invalid statements
+                bool parsed = materialize(fun, _errors);
+                _ok         = _ok && parsed && !fun->lazy.invalid();
+            }
+        }
+        node_fields(*this, node);
+    }
+
+    String               data;
+    String               text;
+    Array<StringRecord>  records;
+    Dict<StringView, uint32> indices;
+    List<String>         text_keys;
+    Array<ParsingError>* _errors = nullptr;
+    bool                 _ok     = true;
+};
+
+// Reader
+// ------
+class ModuleReader {
+    public:
+    static constexpr bool loading = true;
+
+    ModuleReader(StringView data, StringView text, Array<StringView> strings, GCObject* root):
+        _data(data), _text(text), _strings(std::move(strings)), _parent(root) {
+        _refs.resize(_strings.size());
+        _interned.resize(_strings.size(), false);
+    }
+
+    bool ok() const { return _ok && _offset == _data.size(); }
+
+    template <typename T>
+    void operator()(T& value) {
+        if constexpr (std::is_arithmetic_v<T> || std::is_enum_v<T>) {
+            pod(value);
+        } else {
+            fields(*this, value);
+        }
+    }
+
+    template <typename T>
+    void operator()(T*& node) {
+        int8 kind = int8(NodeKind::Invalid);
+        pod(kind);
+
+        node = nullptr;
+        if (kind == int8(NodeKind::Invalid)) {
+            return;
+        }
+
+        Node* obj = read_node(NodeKind(kind));
+
+        if (obj == nullptr || !compatible<T>(obj)) {
+            _ok = false;
+            return;
+        }
+        node = static_cast<T*>(obj);
+    }
+
+    template <typename T>
+    void operator()(Optional<T>& value) {
+        bool has_value = false;
+        pod(has_value);
+
+        value = Optional<T>();
+        if (has_value) {
+            T item = blank<T>();
+            (*this)(item);
+            value = item;
+        }
+    }
+
+    template <typename T>
+    void operator()(Array<T>& values) {
+        uint32 size = 0;
+        pod(size);
+
+        values.clear();
+
+        // every element takes at least a byte
+        if (size > _data.size() - _offset) {
+            _ok = false;
+            return;
+        }
+
+        values.reserve(size);
+        for (uint32 i = 0; i < size && _ok; i++) {
+            T item = blank<T>();
+            (*this)(item);
+            values.push_back(item);
+        }
+    }
+
+    void operator()(String& value) { value = String(string()); }
+
+    void operator()(StringRef& value) {
+        uint32 index = 0;
+        pod(index);
+
+        if (index >= _strings.size()) {
+            _ok = false;
+            return;
+        }
+
+        if (!_interned[index]) {
+            _refs[index]     = StringRef(String(_strings[index]));
+            _interned[index] = true;
+        }
+        value = _refs[index];
+    }
+
+    void operator()(Token& tok) {
+        int8  type = 0;
+        int8  op   = 0;
+        int32 line = 0;
+        int32 col  = 0;
+
+        pod(type);
+        pod(op);
+        pod(line);
+        pod(col);
+        StringView text = string();
+
+        if (op < 0 || op >= operator_count) {
+            _ok = false;
+            return;
+        }
+        tok = Token(type, line, col, text, op);
+    }
+
+    void operator()(ConstantValue& value) {
+        int8 type = 0;
+        pod(type);
+
+        // clang-format off
+        switch (ConstantValue::Type(type)) {
+        #define POD(k, type, name) case ConstantValue::T##k: { type v{}; pod(v); value = ConstantValue(v); return; }
+        #define CPX(k, type, name) case ConstantValue::T##k: { value = ConstantValue(String(string())); return; }
+
+        NUMERIC_CONSTANT(POD)
+        CPX(String, String, string)
+
+        #undef CPX
+        #undef POD
+        case ConstantValue::TNone: value = ConstantValue::none(); return;
+        case ConstantValue::TInvalid: value = ConstantValue(); return;
+        default: _ok = false; return;
+        }
+        // clang-format on
+    }
+
+    private:
+    template <typename T>
+    void pod(T& value) {
+        if (!_ok || _data.size() - _offset < sizeof(T)) {
+            _ok = false;
+            return;
+        }
+        std::memcpy(&value, _data.data() + _offset, sizeof(T));
+        _offset += sizeof(T);
+    }
+
+    StringView string() {
+        uint32 index = 0;
+        pod(index);
+
+        if (index >= _strings.size()) {
+            _ok = false;
+            return StringView();
+        }
+        return _strings[index];
+    }
+
+    // Nodes are allocated by their parent, they share the arena of the module
+    template <typename T>
+    Node* make_node() {
+        T* node = _parent->new_object<T>();
+
+        GCObject* parent = _parent;
+        _parent          = node;
+
+        base_fields(*this, node);
+        fields(*this, *node);
+
+        _parent = parent;
+        return node;
+    }
+
+    Node* read_node(NodeKind kind) {
+        // clang-format off
+        switch (kind) {
+            #define X(name, _)
+            #define SECTION(_)
+            #define NODE(name, _)\
+                case NodeKind::name: return make_node<name>();
+            #define MOD(name, _)
+
+            NODEKIND_ENUM(X, SECTION, NODE, NODE, MOD, NODE)
+
+            #undef X
+            #undef SECTION
+            #undef NODE
+            #undef MOD
+
+            default: return nullptr;
+        }
+        // clang-format on
+    }
+
+    StringView         _data;
+    StringView         _text;
+    Array<StringView>  _strings;
+    Array<StringRef>   _refs;
+    Array<bool>        _interned;
+    GCObject*          _parent;
+    std::size_t        _offset = 0;
+    bool               _ok     = true;
+};
+
+}  // namespace
+
+String module_file_path(String const& source_path) { return source_path + "c"; }
+
+String dump_module(Module* mod, uint64 hash, uint64 source_size, Array<ParsingError>* errors) {
+    ModuleWriter writer(errors);
+    fields(writer, *mod);
+
+    if (!writer.ok()) {
+        return String();
+    }
+    return writer.result(hash, source_size);
+}
+
+bool read_module_header(StringView data, ModuleFileHeader& header) {
+    if (data.size() < sizeof(header)) {
+        return false;
+    }
+    std::memcpy(&header, data.data(), sizeof(header));
+
+    std::size_t expected_size = sizeof(header) +
+                                std::size_t(header.string_count) * sizeof(StringRecord) +
+                                header.data_size + header.text_size;
+
+    return std::memcmp(header.magic, "LYCM", 4) == 0 && header.version == module_file_version &&
+           data.size() == expected_size;
+}
+
+Module* load_module(StringView data) {
+    ModuleFileHeader header;
+    if (!read_module_header(data, header)) {
+        return nullptr;
+    }
+
+    const char* records = data.data() + sizeof(header);
+    const char* nodes   = records + std::size_t(header.string_count) * sizeof(StringRecord);
+    const char* text    = nodes + header.data_size;
+
+    Array<StringView> strings;
+    strings.reserve(header.string_count);
+
+    for (uint32 i = 0; i < header.string_count; i++) {
+        StringRecord record;
+        std::memcpy(&record, records + i * sizeof(StringRecord), sizeof(StringRecord));
+
+        if (std::size_t(record.offset) + record.size > header.text_size) {
+            return nullptr;
+        }
+        strings.emplace_back(text + record.offset, record.size);
+    }
+
+    Module* mod   = new Module();
+    mod->class_id = meta::type_id<Module>();
+    mod->enable_arena();
+
+    ModuleReader reader(StringView(nodes, header.data_size),
+                        StringView(text, header.text_size),
+                        std::move(strings),
+                        mod);
+    fields(reader, *mod);
+
+    if (!reader.ok()) {
+        delete mod;
+        return nullptr;
+    }
+    return mod;
+}
+
+bool save_module(String const&        path,
+                 Module*              mod,
+                 uint64               hash,
+                 uint64               source_size,
+                 Array<ParsingError>* errors) {
+    String data = dump_module(mod, hash, source_size, errors);
+    if (data.empty()) {
+        return false;
+    }
+
+    String tmp  = path + ".tmp";
+    FILE*  file = fopen(tmp.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+
+    bool ok = fwrite(data.data(), 1, data.size(), file) == data.size();
+    ok      = (fclose(file) == 0) && ok;
+
+    std::error_code err;
+    if (ok) {
+        std::filesystem::rename(tmp.c_str(), path.c_str(), err);
+    }
+    if (!ok || err) {
+        std::filesystem::remove(tmp.c_str(), err);
+        return false;
+    }
+    return true;
+}
+
+Module* load_module_file(String const& path, uint64 hash, uint64 source_size) {
+    std::error_code err;
+    if (!std::filesystem::is_regular_file(path.c_str(), err)) {
+        return nullptr;
+    }
+
+    MappedFileBuffer file(path);
+    StringView       data = file.source();
+
+    ModuleFileHeader header;
+    if (!read_module_header(data, header) || header.hash != hash ||
+        header.source_size != source_size) {
+        return nullptr;
+    }
+    return load_module(data);
+}
+
+}  // namespace lython
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "ast/nodes.h"
+#include "dtypes.h"
+#include "parser/parsing_error.h"
+
+namespace lython {
+
+/*
+ *  Parsed modules saved on disk so unchanged imports do not need to be parsed again
+ *
+ *  Layout (native endianness)
+ *
+ *      ModuleFileHeader
+ *      StringRecord[string_count]
+ *      char data[data_size]        nodes in pre-order, children follow their parent
+ *      char text[text_size]        deduplicated strings (identifiers, docstrings, constants...)
+ *
+ *  Nodes are written as their kind followed by their fields, strings are indices
+ *  in the string table so the node stream does not hold any pointer.
+ *  The file is mapped in memory and decoded in a single pass,
+ *  the nodes are allocated from the arena of the loaded module.
+ *
+ *  Only what the parser produces is saved, what sema resolves is computed again.
+ */
+struct ModuleFileHeader {
+    char   magic[4];      // LYCM
+    uint32 version;       //
+    uint64 hash;          // hash of the source the module was parsed from
+    uint64 source_size;   //
+    uint32 string_count;  //
+    uint32 data_size;     //
+    uint32 text_size;     //
+    uint32 padding;
+};
+
+struct StringRecord {
+    uint32 offset;  // offset inside the text section
+    uint32 size;    //
+};
+
+static constexpr uint32 module_file_version = 2;
+
+// foo.ly -> foo.lyc
+String module_file_path(String const& source_path);
+
+// Serialize a module, bodies skipped by a lazy parser are parsed first.
+// Returns an empty string if one of them had syntax errors, they are appended to errors
+String dump_module(Module*              mod,
+                   uint64               hash,
+                   uint64               source_size,
+                   Array<ParsingError>* errors = nullptr);
+
+// Validate the header of a serialized module
+bool read_module_header(StringView data, ModuleFileHeader& header);
+
+// Decode a serialized module, returns nullptr if the data is malformed
+Module* load_module(StringView data);
+
+// Write the module next to its destination and then rename it,
+// concurrent readers never see a partial file.
+// Nothing is written if a lazily skipped body had syntax errors, see dump_module()
+bool save_module(String const&        path,
+                 Module*              mod,
+                 uint64               hash,
+                 uint64               source_size,
+                 Array<ParsingError>* errors = nullptr);
+
+// Load a module saved by save_module(),
+// returns nullptr if the file is missing, malformed or was saved for another source
+Module* load_module_file(String const& path, uint64 hash, uint64 source_size);
+
+}  // namespace lython
@@ -0,0 +1,359 @@
+#include "ast/fields.h"
+#include "parser/parser.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace lython {
+
+namespace {
+
+constexpr int32 end_of_file = std::numeric_limits<int32>::max();
+
+bool is_line_prefix(int type) { return in(type, tok_newline, tok_desindent, tok_indent); }
+
+// Moves the nodes that follow an edit by the number of lines it added
+struct LineShift: NodeWalker<LineShift> {
+    LineShift(int32 delta_): delta(delta_) {}
+
+    int32 delta;
+
+    void location(CommonAttributes& loc) {
+        if (loc.lineno() > 0) {
+            loc.set_start(loc.lineno() + delta, loc.col_offset());
+        }
+        end(loc);
+    }
+
+    void token(Token& tok) {
+        tok = Token(tok.type(), tok.line() + delta, tok.col(), tok.identifier(), tok.operator_id());
+    }
+
+    // Only the end of the nodes enclosing the edit moves
+    void end(CommonAttributes& loc) {
+        Optional<int> line = loc.end_lineno();
+        if (line.has_value() && line.value() > 0) {
+            loc.set_end(line.value() + delta, loc.end_col_offset());
+        }
+    }
+
+    void node(Node* n) {
+        walk(n);
+
+        // the skipped body is replayed with its own tokens
+        if (n->kind == NodeKind::FunctionDef) {
+            (*this)(static_cast<FunctionDef*>(n)->lazy.tokens);
+        }
+    }
+};
+
+// First line of a statement, decorators included; -1 if it is not known
+int32 first_line(StmtNode* stmt) {
+    Array<Decorator>* decorators = nullptr;
+
+    switch (stmt->kind) {
+    case NodeKind::FunctionDef: decorators = &static_cast<FunctionDef*>(stmt)->decorator_list; break;
+    case NodeKind::ClassDef: decorators = &static_cast<ClassDef*>(stmt)->decorator_list; break;
+    case NodeKind::InvalidStatement: {
+        // the parser does not locate the statements it could not parse
+        Array<Token> const& tokens = static_cast<InvalidStatement*>(stmt)->tokens;
+        return tokens.empty() ? -1 : tokens[0].line();
+    }
+    default: break;
+    }
+
+    int32 line = stmt->lineno();
+    if (decorators != nullptr) {
+        for (Decorator const& deco: *decorators) {
+            if (deco.expr != nullptr && deco.expr->lineno() > 0) {
+                line = std::min(line, deco.expr->lineno());
+            }
+        }
+    }
+    return line > 0 ? line : -1;
+}
+
+// Body of the definitions a block can be re-parsed in
+Array<StmtNode*>* nested_body(StmtNode* stmt) {
+    switch (stmt->kind) {
+    case NodeKind::FunctionDef: {
+        FunctionDef* fun = static_cast<FunctionDef*>(stmt);
+        return fun->lazy.pending() ? nullptr : &fun->body;
+    }
+    case NodeKind::ClassDef: return &static_cast<ClassDef*>(stmt)->body;
+    default: return nullptr;
+    }
+}
+
+// Index of the first token with line >= line, the tokens that only end
+// the previous line are skipped
+std::size_t line_token(Array<Token> const& tokens, int32 line, bool skip_indent) {
+    if (line == end_of_file) {
+        return tokens.size();
+    }
+
+    auto it = std::lower_bound(tokens.begin(), tokens.end(), line, [](Token const& tok, int32 l) {
+        return tok.line() < l;
+    });
+
+    while (it != tokens.end() && in(it->type(), tok_newline, tok_desindent)) {
+        it += 1;
+    }
+    while (skip_indent && it != tokens.end() && it->type() == tok_indent) {
+        it += 1;
+    }
+    return std::size_t(it - tokens.begin());
+}
+
+// Line of the last token before index that is not an indentation token
+int32 previous_line(Array<Token> const& tokens, std::size_t index) {
+    while (index > 0) {
+        index -= 1;
+        if (!is_line_prefix(tokens[index].type())) {
+            return tokens[index].line();
+        }
+    }
+    return 1;
+}
+
+struct Reparse {
+    String const& file_name;
+    bool          lazy_bodies;
+    bool          throw_errors;
+    Module*       mod;
+    Array<Token>& tokens;
+    int32         delta;
+
+    // errors of the previous parse, the ones of the statements parsed again are replaced
+    Array<ParsingError>& errors;
+
+    // lines touched by the edit, first is the same in both streams,
+    // last is in the lines of the previous stream
+    int32 first = 1;
+    int32 last  = 1;
+
+    // The statements of a block and the lines they start in, in the previous stream
+    // the statement k spans [starts[k], starts[k + 1])
+    bool statement_lines(Array<StmtNode*>& body, Array<int32>& starts) {
+        starts.reserve(body.size());
+
+        for (StmtNode* stmt: body) {
+            int32 line = first_line(stmt);
+            if (line < 0 || (!starts.empty() && line < starts.back())) {
+                return false;
+            }
+            starts.push_back(line);
+        }
+        return true;
+    }
+
+    // Replace the statements [i, j) of a block with the statements parsed from the lines
+    // [start, end) of the new stream.
+    // Fails when the new lines do not form a block on their own: the edit changed
+    // the indentation around them
+    bool replace(Node* owner, Array<StmtNode*>& body, std::size_t i, std::size_t j, int32 start, int32 end,
+                 bool nested) {
+        // the first statement of a body comes after the indentation that opens it
+        std::size_t begin = i == 0 && !nested ? 0 : line_token(tokens, start, nested && i == 0);
+        std::size_t stop  = line_token(tokens, end == end_of_file ? end : end + delta, false);
+
+        Array<Token> slice;
+        slice.reserve(stop - begin + 1);
+
+        int  level      = 0;
+        bool escaped    = false;
+        bool statements = false;
+        bool comments   = false;
+
+        for (std::size_t k = begin; k < stop; k++) {
+            Token const& tok = tokens[k];
+
+            if (tok.type() == tok_desindent && level == 0) {
+                // closes the block, only the indentation of the lines that follow can come after
+                escaped = true;
+                continue;
+            }
+            if (escaped && !in(tok.type(), tok_newline, tok_desindent, tok_eof)) {
+                return false;
+            }
+
+            level += tok.type() == tok_indent;
+            level -= tok.type() == tok_desindent;
+            comments |= tok.type() == tok_comment;
+            statements |= !is_line_prefix(tok.type()) && !in(tok.type(), tok_comment, tok_eof);
+            slice.push_back(tok);
+        }
+
+        // the lexer does not close the blocks still open at the end of the file
+        bool at_eof = !slice.empty() && slice.back().type() == tok_eof;
+        if (level != 0 && !at_eof) {
+            return false;
+        }
+
+        // the statements were removed, an empty block is a syntax error for the parser
+        if (!statements) {
+            if (comments || (nested && i == 0 && j == body.size())) {
+                return false;
+            }
+            body.erase(body.begin() + i, body.begin() + j);
+            shift(body, i);
+            replace_errors(start, end, {});
+            return true;
+        }
+
+        ReplayLexer lex(slice, file_name);
+        Parser      sub(lex);
+        sub.set_lazy_bodies(lazy_bodies);
+        sub.set_throw_errors(throw_errors);
+
+        Module* part = sub.parse_module();
+
+        // comments ending a nested block are moved to the next statement of the parent block
+        // by a full parse, they would stay at the end of the block here
+        if (nested && j == body.size() && !part->body.empty() &&
+            part->body.back()->kind == NodeKind::Comment) {
+            delete part;
+            return false;
+        }
+
+        for (StmtNode* stmt: part->body) {
+            owner->add_child(stmt);
+        }
+
+        std::size_t count = part->body.size();
+        body.erase(body.begin() + i, body.begin() + j);
+        body.insert(body.begin() + i, part->body.begin(), part->body.end());
+
+        part->body.clear();
+        mod->arenas.push_back(std::move(part->arena));
+        delete part;
+
+        shift(body, i + count);
+        replace_errors(start, end, sub.get_errors());
+        return true;
+    }
+
+    // Drop the errors of the lines [start, end) of the previous stream, move the ones
+    // after them and add the errors of the statements that replaced them
+    void replace_errors(int32 start, int32 end, Array<ParsingError> const& replacement) {
+        auto removed = std::remove_if(errors.begin(), errors.end(), [&](ParsingError const& error) {
+            int32 line = error.received_token.line();
+            return line >= start && (end == end_of_file || line < end);
+        });
+        errors.erase(removed, errors.end());
+
+        if (delta != 0 && end != end_of_file) {
+            LineShift shifter{delta};
+            for (ParsingError& error: errors) {
+                if (error.received_token.line() >= end) {
+                    shifter.token(error.received_token);
+                }
+            }
+        }
+
+        for (ParsingError const& error: replacement) {
+            errors.push_back(error);
+        }
+
+        std::stable_sort(errors.begin(), errors.end(), [](ParsingError const& a, ParsingError const& b) {
+            return a.received_token.line() < b.received_token.line();
+        });
+    }
+
+    void shift(Array<StmtNode*>& body, std::size_t from) {
+        if (delta == 0) {
+            return;
+        }
+
+        LineShift shifter{delta};
+        for (std::size_t k = from; k < body.size(); k++) {
+            shifter(body[k]);
+        }
+    }
+
+    // Re-parse the statements of the block touched by the edit, or the innermost
+    // definition of the block holding all of it.
+    // Nested blocks span [block_start, block_end), they give up when the edit reaches their bounds
+    bool block(Node* owner, Array<StmtNode*>& body, int32 block_start, int32 block_end, bool nested) {
+        Array<int32> starts;
+
+        if (!statement_lines(body, starts) || body.empty()) {
+            return !nested && replace(owner, body, 0, body.size(), 1, end_of_file, false);
+        }
+
+        if (nested && first < block_start) {
+            return false;
+        }
+
+        auto region_start = [&](std::size_t k) { return k == 0 ? block_start : starts[k]; };
+        auto region_end   = [&](std::size_t k) { return k + 1 < starts.size() ? starts[k + 1] : block_end; };
+
+        std::size_t i = 0;
+        while (i + 1 < body.size() && region_end(i) <= first) {
+            i += 1;
+        }
+
+        std::size_t j = i;
+        while (j + 1 < body.size() && region_start(j + 1) <= last) {
+            j += 1;
+        }
+
+        if (nested && last >= block_end) {
+            return false;
+        }
+
+        // the edit is inside a single definition, try its body first
+        StmtNode*         stmt  = body[i];
+        Array<StmtNode*>* inner = i == j ? nested_body(stmt) : nullptr;
+
+        if (inner != nullptr && !inner->empty()) {
+            int32 inner_start = first_line((*inner)[0]);
+
+            if (inner_start > stmt->lineno() &&
+                block(stmt, *inner, inner_start, region_end(i), true)) {
+                LineShift{delta}.end(*stmt);
+                shift(body, i + 1);
+                return true;
+            }
+        }
+
+        if (replace(owner, body, i, j + 1, region_start(i), region_end(j), nested)) {
+            return true;
+        }
+
+        // the indentation changed, the whole module needs to be parsed again
+        return !nested && replace(owner, body, 0, body.size(), 1, end_of_file, false);
+    }
+};
+
+}  // namespace
+
+void Parser::reparse(Module* mod, Array<Token>& tokens, TokenRange const& range) {
+    if (range.begin == range.old_end && range.begin == range.new_end) {
+        return;
+    }
+
+    Reparse edit{_lex.file_name(), lazy_bodies, throw_errors, mod, tokens, range.line_delta, errors};
+
+    // a change at the start of a line can move it to another block,
+    // the line before it is parsed again as well
+    std::size_t begin = range.begin;
+    bool        line_start =
+        begin >= tokens.size() || is_line_prefix(tokens[begin].type()) ||
+        (begin > 0 && is_line_prefix(tokens[begin - 1].type()));
+
+    edit.first = line_start ? previous_line(tokens, begin) : tokens[begin].line();
+
+    int32 last = edit.first;
+    for (std::size_t k = begin; k < range.new_end && k < tokens.size(); k++) {
+        if (!is_line_prefix(tokens[k].type())) {
+            last = std::max(last, tokens[k].line());
+        }
+    }
+    edit.last = std::max(edit.first, last - range.line_delta);
+
+    edit.block(mod, mod->body, 1, end_of_file, false);
+    current_error = int(errors.size()) - 1;
+}
+
+}  // namespace lython
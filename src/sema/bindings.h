@@ -19,10 +19,11 @@ struct BindingEntry {
     }
 
     StringRef name;
-    Node*     value   = nullptr;
-    TypeExpr* type    = nullptr;
-    bool      dynamic = false;  // used to specify that this entry is dynamic
-                                // and its address can change at runtime
+    Node*     value    = nullptr;
+    TypeExpr* type     = nullptr;
+    bool      dynamic  = false;  // used to specify that this entry is dynamic
+                                 // and its address can change at runtime
+    int       shadowed = -1;     // previous binding with the same name
 };
 
 std::ostream& print(std::ostream& out, BindingEntry const& entry);
@@ -51,6 +52,7 @@ struct Bindings {
 
         bool dynamic = !nested;
         bindings.push_back({name, value, type, dynamic});
+        index_entry(size);
 
         if (!nested) {
             global_index += 1;
@@ -97,21 +99,19 @@ struct Bindings {
 
     bool is_dynamic(int varid) const { return varid >= global_index; }
 
+    // the most recent binding of the name shadows the others
     int get_varid(StringRef name) const {
         COZ_BEGIN("T::Bindings::get_varid");
 
-        auto start = std::rbegin(bindings);
-        auto end   = std::rend(bindings);
-
         int value = -1;
-        int i     = 0;
-        while (start != end) {
-            if (start->name == name) {
-                value = int(bindings.size()) - i - 1;
-                break;
+
+        if (name) {
+            auto result = index.find(name.__id__());
+            if (result != index.end()) {
+                value = result->second;
             }
-            ++start;
-            i += 1;
+        } else {
+            value = get_unnamed_varid();
         }
 
         COZ_PROGRESS_NAMED("Bindings::get_varid");
@@ -119,6 +119,39 @@ struct Bindings {
         return value;
     }
 
+    // the binding of the name in the global scope, the local ones shadowing it are skipped
+    int get_global_varid(StringRef name) const {
+        int varid = get_varid(name);
+        while (varid >= 0 && is_dynamic(varid)) {
+            varid = bindings[varid].shadowed;
+        }
+        return varid;
+    }
+
+    // Remove the bindings added after size, the names they shadowed become visible again
+    void truncate(std::size_t size) {
+        while (bindings.size() > size) {
+            BindingEntry const& entry = bindings.back();
+
+            if (entry.name) {
+                if (entry.shadowed < 0) {
+                    index.erase(entry.name.__id__());
+                } else {
+                    index[entry.name.__id__()] = entry.shadowed;
+                }
+            }
+            bindings.pop_back();
+        }
+    }
+
+    // Append the bindings of other until size, the prefixes of both need to be the same
+    void extend(Bindings const& other, std::size_t size) {
+        while (bindings.size() < size) {
+            bindings.push_back(other.bindings[bindings.size()]);
+            index_entry(int(bindings.size()) - 1);
+        }
+    }
+
     String __str__() const {
         StringStream ss;
         dump(ss);
@@ -133,6 +166,36 @@ struct Bindings {
     // so we know when we need to do a dynamic lookup of a static one
     int  global_index = 0;
     bool nested       = false;
+
+    private:
+    // The evaluator pushes a lot of temporaries without a name,
+    // they are only reached through their varid and are not indexed
+    void index_entry(int varid) {
+        BindingEntry& entry = bindings[varid];
+        if (!entry.name) {
+            return;
+        }
+
+        auto result = index.find(entry.name.__id__());
+        if (result != index.end()) {
+            entry.shadowed = result->second;
+            result->second = varid;
+        } else {
+            index[entry.name.__id__()] = varid;
+        }
+    }
+
+    int get_unnamed_varid() const {
+        for (int i = int(bindings.size()) - 1; i >= 0; i--) {
+            if (!bindings[i].name) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    // name id -> most recent binding of the name
+    Dict<std::size_t, int> index;
 };
 
 struct Scope {
@@ -141,7 +204,7 @@ struct Scope {
     }
 
     ~Scope() {
-        bindings.bindings.resize(oldsize);
+        bindings.truncate(oldsize);
         bindings.nested = false;
     }
 
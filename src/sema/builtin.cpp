@@ -18,6 +18,34 @@ BUILTIN_TYPES(TYPE)
 
 #undef TYPE
 
+BuiltinTypeId builtin_type_id(TypeExpr* type) {
+    StringRef const* name = nullptr;
+
+    if (type == nullptr) {
+        return BuiltinTypeId::Count;
+    }
+
+    switch (type->kind) {
+    case NodeKind::Name: name = &static_cast<Name*>(type)->id; break;
+    case NodeKind::BuiltinType: name = &static_cast<BuiltinType*>(type)->name; break;
+    default: return BuiltinTypeId::Count;
+    }
+
+    // the builtin types are referred to by their name, comparing references is enough
+    static StringRef const names[] = {
+#define TYPE(name) StringRef(#name),
+        BUILTIN_TYPES(TYPE)
+#undef TYPE
+    };
+
+    for (int i = 0; i < builtin_type_count; i++) {
+        if (names[i] == *name) {
+            return BuiltinTypeId(i);
+        }
+    }
+    return BuiltinTypeId::Count;
+}
+
 ExprNode* None() {
     static Constant constant(ConstantValue::none());
     return &constant;
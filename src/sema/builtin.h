@@ -34,6 +34,20 @@ BUILTIN_TYPES(TYPE)
 
 #undef TYPE
 
+// Index of the builtin types, in the order of BUILTIN_TYPES
+enum class BuiltinTypeId : int8
+{
+#define TYPE(name) T##name,
+    BUILTIN_TYPES(TYPE)
+#undef TYPE
+    Count
+};
+
+constexpr int builtin_type_count = int(BuiltinTypeId::Count);
+
+// Builtin type a type expression refers to, Count if it is not a builtin type
+BuiltinTypeId builtin_type_id(TypeExpr* type);
+
 }  // namespace lython
 
 #endif
\ No newline at end of file
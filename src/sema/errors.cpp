@@ -82,6 +82,12 @@ std::string ImportError::message(String const& module, String const& name) {
     return fmt::format("ImportError: cannot import name {} from '{}'", name, module);
 }
 
+std::string DeferredSyntaxError::message() const { return message(kind, msg); }
+
+std::string DeferredSyntaxError::message(String const& kind, String const& msg) {
+    return fmt::format("{}: {}", kind, msg);
+}
+
 std::string RecursiveDefinition::message() const { return message(fun, cls); }
 
 std::string RecursiveDefinition::message(ExprNode const* fun, ClassDef const* cls) {
@@ -123,7 +129,7 @@ void SemaErrorPrinter::print(SemaException const& err) {
     bool written = false;
 
     if (err.stmt != nullptr) {
-        line = err.stmt->lineno;
+        line = err.stmt->lineno();
     }
 
     firstline() << "File \"" << filename << "\", line " << line << ", in " << parent;
@@ -153,11 +159,11 @@ void SemaErrorPrinter::underline(CommonAttributes const& attr) {
 
     int32 size = 1;
 
-    if (attr.end_col_offset.has_value()) {
-        size = std::max(attr.end_col_offset.value() - attr.col_offset, 1);
+    if (attr.end_col_offset().has_value()) {
+        size = std::max(attr.end_col_offset().value() - attr.col_offset(), 1);
     }
 
-    int32 start = std::max(1, attr.col_offset);
+    int32 start = std::max(1, attr.col_offset());
     codeline() << String(start, ' ') << String(size, '^');
 }
 
@@ -179,6 +179,27 @@ struct ImportError: public SemaException {
     StringRef name;
 };
 
+/*
+ * Syntax error in the body of a function skipped by a lazy parser,
+ * it is only found once sema parses the body
+ *
+ * Examples
+ * --------
+ * >>> def f():
+ * ...     x = )
+ * SyntaxError: unmatched ')'
+ */
+struct DeferredSyntaxError: public SemaException {
+    DeferredSyntaxError(String const& kind, String const& msg): kind(kind), msg(msg) {}
+
+    std::string message() const override;
+
+    static std::string message(String const& kind, String const& msg);
+
+    String kind;
+    String msg;
+};
+
 struct SemaErrorPrinter {
     SemaErrorPrinter(std::ostream& out, class AbstractLexer* lexer = nullptr):
         out(out), lexer(lexer)  //
@@ -0,0 +1,188 @@
+#include "sema/modules.h"
+#include "lexer/buffer.h"
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "parser/precompiled.h"
+#include "sema/sema.h"
+#include "utilities/strings.h"
+
+#include <filesystem>
+
+namespace lython {
+
+namespace {
+
+Module* parse_source(MappedFileBuffer& buffer, String const& path) {
+    // precompiled by `lython compile`, only used while the source is unchanged
+    Module* precompiled =
+        load_module_file(module_file_path(path), buffer.hash(), buffer.source().size());
+    if (precompiled != nullptr) {
+        return precompiled;
+    }
+
+    // the bodies are parsed when sema reaches them, which reports their syntax errors
+    Lexer  lexer(buffer);
+    Parser parser(lexer);
+    parser.set_lazy_bodies(true);
+    return parser.parse_module();
+}
+
+}  // namespace
+
+ModuleRegistry& ModuleRegistry::instance() {
+    static ModuleRegistry registry;
+    return registry;
+}
+
+ImportedModule ModuleRegistry::import(StringRef const& name, Array<String> const& paths) {
+    namespace fs = std::filesystem;
+
+    // the lookup goes through the file system, it is only done once per set of paths
+    String key = fmtstr("{}:{}", str(name), join(":", paths));
+    String path;
+    bool   resolved = false;
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        auto result = _resolved.find(key);
+        if (result != _resolved.end()) {
+            path     = result->second;
+            resolved = true;
+        }
+    }
+
+    if (!resolved) {
+        path = lookup_module(name, paths);
+
+        if (!path.empty()) {
+            path = String(fs::weakly_canonical(fs::path(path.c_str())).string().c_str());
+        }
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        _resolved[key] = path;
+    }
+
+    if (path.empty()) {
+        return ImportedModule();
+    }
+
+    // the source is hashed on each import, a module that changed is loaded again
+    MappedFileBuffer buffer(path);
+    uint64           hash = buffer.hash();
+
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    while (true) {
+        Unique<LoadedModule>& latest = _modules[path];
+
+        if (latest == nullptr || latest->hash != hash) {
+            break;
+        }
+
+        LoadedModule* entry = latest.get();
+
+        // a circular import gets the module being loaded, if this thread is the one analysing it
+        if (!entry->ready && !wait(lock, entry)) {
+            bool loading = entry->loader == std::this_thread::get_id();
+            return ImportedModule{true, loading ? entry->module.get() : nullptr, nullptr};
+        }
+
+        if (!entry->failed) {
+            return ImportedModule{true, entry->module.get(), &entry->bindings};
+        }
+
+        // the loader raised and retired the entry, look again
+    }
+
+    Unique<LoadedModule>& latest = _modules[path];
+    if (latest != nullptr) {
+        _previous.push_back(std::move(latest));
+    }
+
+    latest = std::make_unique<LoadedModule>();
+
+    LoadedModule* entry = latest.get();
+    entry->path         = path;
+    entry->hash         = hash;
+    entry->loader       = std::this_thread::get_id();
+    lock.unlock();
+
+    return load(entry, buffer, paths);
+}
+
+ImportedModule
+ModuleRegistry::load(LoadedModule* entry, MappedFileBuffer& buffer, Array<String> const& paths) {
+    SemanticAnalyser sema;
+    sema.paths = paths;
+
+    auto done = [&](bool analysed) {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        if (analysed) {
+            entry->bindings = std::move(sema.bindings);
+        } else {
+            // kept alive for the threads waiting on it, the next import loads the module again
+            entry->failed = true;
+
+            auto latest = _modules.find(entry->path);
+            if (latest != _modules.end() && latest->second.get() == entry) {
+                _previous.push_back(std::move(latest->second));
+                _modules.erase(latest);
+            }
+        }
+        entry->ready = true;
+        _loaded.notify_all();
+    };
+
+    try {
+        Module* mod = parse_source(buffer, entry->path);
+        {
+            // visible to the circular imports from here
+            std::lock_guard<std::mutex> lock(_mutex);
+            entry->module.reset(mod);
+        }
+
+        sema.exec(mod, 0);
+    } catch (...) {
+        done(false);
+        throw;
+    }
+
+    done(true);
+    return ImportedModule{true, entry->module.get(), &entry->bindings};
+}
+
+bool ModuleRegistry::wait(std::unique_lock<std::mutex>& lock, LoadedModule* entry) {
+    std::thread::id self = std::this_thread::get_id();
+
+    // follow the modules the loaders are waiting for, reaching this thread is a cycle
+    LoadedModule* current = entry;
+    while (current != nullptr && !current->ready) {
+        if (current->loader == self) {
+            return false;
+        }
+
+        auto waiting = _waiting.find(current->loader);
+        current      = waiting != _waiting.end() ? waiting->second : nullptr;
+    }
+
+    _waiting[self] = entry;
+    _loaded.wait(lock, [entry]() { return entry->ready; });
+    _waiting.erase(self);
+    return true;
+}
+
+std::size_t ModuleRegistry::size() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _modules.size() + _previous.size();
+}
+
+void ModuleRegistry::clear() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _resolved.clear();
+    _modules.clear();
+    _previous.clear();
+}
+
+}  // namespace lython
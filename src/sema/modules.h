@@ -0,0 +1,87 @@
+#ifndef LYTHON_SEMA_MODULES_HEADER
+#define LYTHON_SEMA_MODULES_HEADER
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "sema/bindings.h"
+
+namespace lython {
+
+class MappedFileBuffer;
+
+// Path of the source of a module, empty if it is not in any of the paths
+String lookup_module(StringRef const& module_path, Array<String> const& paths);
+
+// A module loaded by an import
+struct LoadedModule {
+    String         path;      // canonical path of the source
+    uint64         hash = 0;  // hash of the source
+    Unique<Module> module;
+    Bindings       bindings;  // bindings of the module once analysed
+
+    // the bindings are only set once the module is ready,
+    // before that the module is being analysed by loader
+    bool            ready  = false;
+    bool            failed = false;  // the loader raised, the module is loaded again
+    std::thread::id loader;
+};
+
+// What an import sees of a module, read under the lock of the registry
+struct ImportedModule {
+    bool            found    = false;    // false if the module is not in the paths
+    Module*         module   = nullptr;  // null while another thread is analysing it
+    Bindings const* bindings = nullptr;  // null until the module is analysed
+};
+
+/*
+ *  Modules imported during the compilation, shared by all the analysers
+ *
+ *  Each module is parsed and analysed once, later imports reuse its AST and its bindings.
+ *  Modules are keyed by the canonical path of their source and its hash,
+ *  a module whose source changed is loaded again; the previous version is kept
+ *  as long as the registry since the analysers that imported it refer to its nodes.
+ *
+ *  Loading is single-flight: threads importing a module that is being loaded
+ *  wait for the thread loading it. A module that imports itself, directly or through
+ *  other modules, gets it partially initialised: its statements are there
+ *  but its bindings are not known yet. When the cycle goes through another thread
+ *  that thread is still analysing the module, the import only knows that it exists.
+ *
+ *  A load that raises is retired, the next import of the module loads it again
+ *  and the threads that were waiting for it retry.
+ */
+class ModuleRegistry {
+    public:
+    static ModuleRegistry& instance();
+
+    // Find the module in the paths, load it on first use.
+    // A circular import gets the module without its bindings, or nothing
+    // when the module is being analysed by another thread
+    ImportedModule import(StringRef const& name, Array<String> const& paths);
+
+    // Number of modules loaded, previous versions included
+    std::size_t size() const;
+
+    // Release all the modules, nothing can refer to them anymore
+    void clear();
+
+    private:
+    ImportedModule load(LoadedModule* entry, MappedFileBuffer& buffer, Array<String> const& paths);
+
+    // Wait for another thread to load the module, returns false if it would wait on itself
+    bool wait(std::unique_lock<std::mutex>& lock, LoadedModule* entry);
+
+    mutable std::mutex      _mutex;
+    std::condition_variable _loaded;
+
+    Dict<String, String>                 _resolved;  // module name and paths -> source
+    Dict<String, Unique<LoadedModule>>   _modules;   // canonical path -> latest version
+    Array<Unique<LoadedModule>>          _previous;  // replaced by a newer source or failed
+    Dict<std::thread::id, LoadedModule*> _waiting;   // thread -> module it waits for
+};
+
+}  // namespace lython
+
+#endif
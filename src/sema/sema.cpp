@@ -1,6 +1,7 @@
 #include "sema/sema.h"
 #include "ast/magic.h"
 #include "builtin/operators.h"
+#include "parser/parser.h"
 #include "dependencies/fmt.h"
 #include "utilities/guard.h"
 #include "utilities/strings.h"
@@ -34,7 +35,7 @@ bool SemanticAnalyser::typecheck(
                     rhs_t->kind);
     }
 
-    auto match = equal(lhs_t, rhs_t);
+    auto match = types.same(lhs_t, rhs_t);
 
     if (!match) {
         SEMA_ERROR(lhs, TypeError, lhs, lhs_t, rhs, rhs_t, loc);
@@ -99,8 +100,8 @@ TypeExpr* SemanticAnalyser::boolop(BoolOp* n, int depth) {
         rhs   = n->values[i];
         rhs_t = exec(rhs, depth);
 
-        String signature = join("-", Array<String>{str(n->op), str(lhs_t), str(rhs_t)});
-        auto   handler   = get_native_bool_operation(signature);
+        auto handler =
+            get_native_bool_operation(n->op, builtin_type_id(lhs_t), builtin_type_id(rhs_t));
 
         if (handler) {
             n->native_operator = handler;
@@ -154,7 +155,7 @@ TypeExpr* SemanticAnalyser::boolop(BoolOp* n, int depth) {
         // if not a bool we need to check for
         //  * __and__ inside the lhs
         //  * __rand__ inside the rhs
-        if (!equal(lhs_t, bool_type)) {
+        if (!types.same(lhs_t, bool_type)) {
 
             ClassDef*    cls = nullptr;
             FunctionDef* fun = nullptr;
@@ -195,8 +196,12 @@ TypeExpr* SemanticAnalyser::resolve_variable(ExprNode* node) {
     Name* name = cast<Name>(node);
 
     if (name) {
-        assert(name->varid >= 0, "Type need to be resolved");
-        return static_cast<TypeExpr*>(bindings.get_value(name->varid));
+        // canonical types are not bound to a variable, they refer to a global
+        int varid = name->varid >= 0 ? name->varid : bindings.get_global_varid(name->id);
+        if (varid < 0) {
+            return nullptr;
+        }
+        return static_cast<TypeExpr*>(bindings.get_value(varid));
     }
 
     return nullptr;
@@ -213,10 +218,8 @@ TypeExpr* SemanticAnalyser::compare(Compare* n, int depth) {
         auto cmp_t = exec(cmp, depth);
 
         // Check if we have a native function to handle this
-        String signature = join(String("-"), Array<String>{str(op), str(prev_t), str(cmp_t)});
-
         // TODO: get return type
-        auto handler = get_native_cmp_operation(signature);
+        auto handler = get_native_cmp_operation(op, builtin_type_id(prev_t), builtin_type_id(cmp_t));
         n->native_operator.push_back(handler);
 
         if (!handler) {
@@ -248,10 +251,8 @@ TypeExpr* SemanticAnalyser::binop(BinOp* n, int depth) {
 
     // Builtin type, all the operations are known
     if (blt) {
-        String signature = join(String("-"), Array<String>{str(n->op), str(lhs_t), str(rhs_t)});
-
-        debug("signature: {}", signature);
-        n->native_operator = get_native_binary_operation(signature);
+        n->native_operator =
+            get_native_binary_operation(n->op, builtin_type_id(lhs_t), builtin_type_id(rhs_t));
 
         // FIXME: get return type
         return lhs_t;
@@ -270,9 +271,7 @@ TypeExpr* SemanticAnalyser::binop(BinOp* n, int depth) {
 TypeExpr* SemanticAnalyser::unaryop(UnaryOp* n, int depth) {
     auto expr_t = exec(n->operand, depth);
 
-    String signature = join("-", Array<String>{str(n->op), str(expr_t)});
-
-    UnaryOp::NativeUnaryOp handler = get_native_unary_operation(signature);
+    UnaryOp::NativeUnaryOp handler = get_native_unary_operation(n->op, builtin_type_id(expr_t));
     if (!handler) {
         SEMA_ERROR(n, UnsupportedOperand, str(n->op), expr_t, nullptr);
     }
@@ -320,10 +319,7 @@ TypeExpr* SemanticAnalyser::dictexpr(DictExpr* n, int depth) {
         }
     }
 
-    DictType* type = n->new_object<DictType>();
-    type->key      = key_t;
-    type->value    = val_t;
-    return type;
+    return types.dict(n, key_t, val_t);
 }
 TypeExpr* SemanticAnalyser::setexpr(SetExpr* n, int depth) {
     TypeExpr* val_t = nullptr;
@@ -338,9 +334,7 @@ TypeExpr* SemanticAnalyser::setexpr(SetExpr* n, int depth) {
         }
     }
 
-    SetType* type = n->new_object<SetType>();
-    type->value   = val_t;
-    return type;
+    return types.set(n, val_t);
 }
 TypeExpr* SemanticAnalyser::listcomp(ListComp* n, int depth) {
     Scope scope(bindings);
@@ -355,9 +349,7 @@ TypeExpr* SemanticAnalyser::listcomp(ListComp* n, int depth) {
 
     auto val_type = exec(n->elt, depth);
 
-    auto type   = n->new_object<ArrayType>();
-    type->value = val_type;
-    return type;
+    return types.array(n, val_type);
 }
 TypeExpr* SemanticAnalyser::generateexpr(GeneratorExp* n, int depth) {
     Scope scope(bindings);
@@ -372,9 +364,7 @@ TypeExpr* SemanticAnalyser::generateexpr(GeneratorExp* n, int depth) {
 
     auto val_type = exec(n->elt, depth);
 
-    auto type   = n->new_object<ArrayType>();
-    type->value = val_type;
-    return type;
+    return types.array(n, val_type);
 }
 TypeExpr* SemanticAnalyser::setcomp(SetComp* n, int depth) {
     Scope scope(bindings);
@@ -389,9 +379,7 @@ TypeExpr* SemanticAnalyser::setcomp(SetComp* n, int depth) {
 
     auto val_type = exec(n->elt, depth);
 
-    auto type   = n->new_object<ArrayType>();
-    type->value = val_type;
-    return type;
+    return types.array(n, val_type);
 }
 
 TypeExpr* SemanticAnalyser::dictcomp(DictComp* n, int depth) {
@@ -408,10 +396,7 @@ TypeExpr* SemanticAnalyser::dictcomp(DictComp* n, int depth) {
     auto key_type = exec(n->key, depth);
     auto val_type = exec(n->value, depth);
 
-    auto type   = n->new_object<DictType>();
-    type->key   = key_type;
-    type->value = val_type;
-    return type;
+    return types.dict(n, key_type, val_type);
 }
 TypeExpr* SemanticAnalyser::await(Await* n, int depth) { return exec(n->value, depth); }
 TypeExpr* SemanticAnalyser::yield(Yield* n, int depth) {
@@ -448,9 +433,13 @@ Node* SemanticAnalyser::load_name(Name_t* n) {
         assert(n->offset != -1, "Reference should have a reverse lookup offset");
         varid  = int(bindings.bindings.size()) - n->offset;
         result = bindings.get_value(varid);
-    } else {
+    } else if (n->varid >= 0) {
         // Global variables
         result = bindings.get_value(n->varid);
+    } else {
+        // Canonical types refer to a global, the locals do not shadow it
+        varid  = bindings.get_global_varid(n->id);
+        result = varid >= 0 ? bindings.get_value(varid) : nullptr;
     }
 
     return result;
@@ -463,7 +452,10 @@ ClassDef* SemanticAnalyser::get_class(ExprNode* classref, int depth) {
         return nullptr;
     }
 
-    cls_name->ctx = ExprContext::Load;
+    // canonical types are shared by every thread, they are already loaded
+    if (cls_name->ctx != ExprContext::Load) {
+        cls_name->ctx = ExprContext::Load;
+    }
     // assert(cls_name->ctx == ExprContext::Load, "Reference to the class should be loaded");
     auto cls = cast<ClassDef>(load_name(cls_name));
 
@@ -483,7 +475,7 @@ SemanticAnalyser::get_arrow(ExprNode* fun, ExprNode* type, int depth, int& offse
         return cast<Arrow>(type);
     }
     case NodeKind::BuiltinType: {
-        if (!equal(type, Type_t())) {
+        if (!types.same(type, Type_t())) {
             return nullptr;
         }
 
@@ -563,18 +555,24 @@ TypeExpr* SemanticAnalyser::call(Call* n, int depth) {
     // Get Arguments and generate an arrow from it
 
     // Create the matching Arrow type for this call
-    Arrow* got = n->new_object<Arrow>();
+    Array<TypeExpr*> args;
     if (arrow != nullptr) {
-        got->args.reserve(arrow->arg_count());
+        args.reserve(arrow->arg_count());
     }
 
     // Method, insert the self argument since it is implicit
+    // a class defined inside a function is not global, its name cannot be canonical
     if (offset == 1 && cls) {
-        got->add_arg_type(make_ref(got, str(cls->name)));
+        int varid = bindings.get_global_varid(cls->name);
+        if (varid >= 0 && bindings.get_value(varid) == cls) {
+            args.push_back(types.name(cls->name));
+        } else {
+            args.push_back(make_ref(n, str(cls->name)));
+        }
     }
 
     for (auto& arg: n->args) {
-        got->add_arg_type(exec(arg, depth));
+        args.push_back(exec(arg, depth));
     }
 
     Dict<StringRef, ExprNode*> kwargs;
@@ -582,41 +580,35 @@ TypeExpr* SemanticAnalyser::call(Call* n, int depth) {
         kwargs[kw.arg] = exec(kw.value, depth);
     }
 
-    if (arrow != nullptr) {
-        for (int i = int(got->arg_count()); i < arrow->names.size(); i++) {
-            auto name = arrow->names[i];
-
-            auto item = kwargs.find(name);
-            if (item == kwargs.end()) {
-                auto value = got->defaults[name];
-                if (value) {
-                    SEMA_ERROR(n, TypeError, fmt::format("Arguement {} is not set", name));
-                }
-                // Got default use the expected type
-                got->add_arg_type(arrow->args[i]);
-                continue;
-            }
-
-            got->add_arg_type(item->second);
-        }
+    if (arrow == nullptr) {
+        return nullptr;
     }
 
-    // FIXME: we do not know the returns so we just use the one we have
-    if (arrow != nullptr) {
-        if (got->arg_count() != arrow->arg_count()) {
-            // we do not really that check
-            // SEMA_ERROR(TypeError(" missing {} required positional arguments"));
-            //
+    for (int i = int(args.size()); i < arrow->names.size(); i++) {
+        auto name = arrow->names[i];
+
+        auto item = kwargs.find(name);
+        if (item == kwargs.end()) {
+            // Got default use the expected type
+            args.push_back(arrow->args[i]);
+            continue;
         }
 
-        got->returns = arrow->returns;
-        typecheck(n, got, n->func, arrow, LOC);
+        args.push_back(item->second);
     }
 
-    if (arrow != nullptr) {
-        return arrow->returns;
+    // FIXME: we do not know the returns so we just use the one we have
+    if (args.size() != arrow->arg_count()) {
+        // we do not really that check
+        // SEMA_ERROR(TypeError(" missing {} required positional arguments"));
+        //
     }
-    return nullptr;
+
+    // the arrow of the call is canonical, checking it against the function is a lookup
+    Arrow* got = types.arrow(n, args, arrow->returns);
+    typecheck(n, got, n->func, arrow, LOC);
+
+    return arrow->returns;
 }
 TypeExpr* SemanticAnalyser::joinedstr(JoinedStr* n, int depth) { return nullptr; }
 TypeExpr* SemanticAnalyser::formattedvalue(FormattedValue* n, int depth) { return nullptr; }
@@ -757,13 +749,11 @@ TypeExpr* SemanticAnalyser::listexpr(ListExpr* n, int depth) {
         }
     }
 
-    ArrayType* type = n->new_object<ArrayType>();
-    type->value     = val_t;
-    return type;
+    return types.array(n, val_t);
 }
 TypeExpr* SemanticAnalyser::tupleexpr(TupleExpr* n, int depth) {
-    TupleType* type = n->new_object<TupleType>();
-    type->types.reserve(n->elts.size());
+    Array<TypeExpr*> elts;
+    elts.reserve(n->elts.size());
 
     for (int i = 0; i < n->elts.size(); i++) {
         TypeExpr* val_t = exec(n->elts[i], depth);
@@ -775,10 +765,10 @@ TypeExpr* SemanticAnalyser::tupleexpr(TupleExpr* n, int depth) {
             val_t = nullptr;
         }
 
-        type->types.push_back(val_t);
+        elts.push_back(val_t);
     }
 
-    return type;
+    return types.tuple(n, elts);
 }
 TypeExpr* SemanticAnalyser::slice(Slice* n, int depth) {
     exec<TypeExpr*>(n->lower, depth);
@@ -954,19 +944,45 @@ TypeExpr* SemanticAnalyser::functiondef(FunctionDef* n, int depth) {
 
     // Create the function type from the arguments
     // this will also add the arguments to the context
-    Arrow*    fun_type = functiondef_arrow(n, lst, depth);
-    TypeExpr* return_t = fun_type->returns;
+    Arrow* fun_type = functiondef_arrow(n, lst, depth);
 
     // Update the function type at the very end
     bindings.set_type(id, fun_type);
 
+    // top level bodies are analysed once the module is known, see exec_parallel()
+    if (forwardpass && lst == nullptr) {
+        DeferredBody body;
+        body.fun          = n;
+        body.type         = fun_type;
+        body.depth        = depth;
+        body.globals      = scope.oldsize;
+        body.global_index = bindings.global_index;
+        body.error        = errors.size();
+        body.arguments.assign(bindings.bindings.begin() + scope.oldsize, bindings.bindings.end());
+        deferred.push_back(body);
+        return fun_type;
+    }
+
+    return functiondef_body(n, fun_type, depth);
+}
+
+TypeExpr* SemanticAnalyser::functiondef_body(FunctionDef* n, Arrow* fun_type, int depth) {
+    // the body might have been skipped by the parser, its syntax errors are found now
+    Array<ParsingError> syntax;
+    if (!materialize(n, &syntax)) {
+        for (ParsingError const& error: syntax) {
+            Node* node = error.stmt != nullptr ? (Node*)error.stmt : (Node*)n;
+            SEMA_ERROR(node, DeferredSyntaxError, error.error_kind, error.message);
+        }
+    }
+
     // Infer return type from the body
     PopGuard ctx(semactx, SemaContext());
     auto     return_effective = exec<TypeExpr*>(n->body, depth);
 
     if (n->returns.has_value()) {
         // Annotated type takes precedence
-        typecheck(n->returns.value(), return_t, nullptr, oneof(return_effective), LOC);
+        typecheck(n->returns.value(), fun_type->returns, nullptr, oneof(return_effective), LOC);
     }
 
     // do decorator last since we need to know our function signature to
@@ -1263,9 +1279,8 @@ TypeExpr* SemanticAnalyser::augassign(AugAssign* n, int depth) {
     auto expected_type = exec(n->target, depth);
     auto type          = exec(n->value, depth);
 
-    String signature = join("-", Array<String>{str(n->op), str(expected_type), str(type)});
-
-    auto handler       = get_native_binary_operation(signature);
+    auto handler = get_native_binary_operation(
+        n->op, builtin_type_id(expected_type), builtin_type_id(type));
     n->native_operator = handler;
 
     if (!handler) {
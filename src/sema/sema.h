@@ -7,6 +7,7 @@
 #include "sema/bindings.h"
 #include "sema/builtin.h"
 #include "sema/errors.h"
+#include "sema/types.h"
 #include "utilities/strings.h"
 
 // #define SEMA_ERROR(exception)      \
@@ -15,6 +16,8 @@
 
 namespace lython {
 
+class ThreadPool;
+
 Array<String> python_paths();
 
 struct SemaVisitorTrait {
@@ -34,6 +37,17 @@ struct SemaContext {
     bool arrow = false;
 };
 
+// Body of a top level function skipped by the forward pass
+struct DeferredBody {
+    FunctionDef*        fun          = nullptr;
+    Arrow*              type         = nullptr;
+    int                 depth        = 0;
+    std::size_t         globals      = 0;  // bindings visible from the body
+    int                 global_index = 0;
+    Array<BindingEntry> arguments;
+    std::size_t         error = 0;  // errors found before the body
+};
+
 /* The semantic analysis (SEM-A) happens after the parsing, the AST can be assumed to be
  * syntactically correct its job is to detect issues that could prevent a succesful compilation.
  *
@@ -94,6 +108,9 @@ struct SemaContext {
  * ImportError
  *      Raised when importing a statement that was not found from a module
  *
+ * DeferredSyntaxError
+ *      Raised when the body of a function skipped by the parser has syntax errors
+ *
  */
 struct SemanticAnalyser: BaseVisitor<SemanticAnalyser, false, SemaVisitorTrait> {
     Bindings                              bindings;
@@ -103,6 +120,8 @@ struct SemanticAnalyser: BaseVisitor<SemanticAnalyser, false, SemaVisitorTrait>
     Array<String>                         namespaces;
     Dict<StringRef, bool>                 flags;
     Array<String>                         paths = python_paths();
+    TypeInterner&                         types = TypeInterner::instance();
+    Array<DeferredBody>                   deferred;
 
     // maybe conbine the semacontext with samespace
     Array<SemaContext> semactx;
@@ -134,6 +153,12 @@ struct SemanticAnalyser: BaseVisitor<SemanticAnalyser, false, SemaVisitorTrait>
     public:
     virtual ~SemanticAnalyser() {}
 
+    // Analyse the module, the bodies of the top level functions are analysed on the pool
+    // after a forward pass over the module. Each body sees the bindings that were defined
+    // before the function, errors and types are the same as the serial analysis.
+    // Modules that do not allocate from an arena are analysed serially
+    void exec_parallel(Module* mod, ThreadPool& pool);
+
     StmtNode* current_namespace() {
         if (nested.size() > 0) {
             return nested[nested.size() - 1];
@@ -153,6 +178,9 @@ struct SemanticAnalyser: BaseVisitor<SemanticAnalyser, false, SemaVisitorTrait>
 
     Arrow* functiondef_arrow(FunctionDef* n, StmtNode* class_t, int depth);
 
+    // the arguments of the function need to be in scope
+    TypeExpr* functiondef_body(FunctionDef* n, Arrow* fun_type, int depth);
+
     String generate_function_name(FunctionDef* n);
 
     Arrow* get_arrow(ExprNode* fun, ExprNode* type, int depth, int& offset, ClassDef*& cls);
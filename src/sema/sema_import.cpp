@@ -10,9 +10,7 @@
 
 #include <filesystem>
 
-#include "lexer/buffer.h"
-#include "lexer/lexer.h"
-#include "parser/parser.h"
+#include "sema/modules.h"
 #include "sema/sema.h"
 #include "utilities/strings.h"
 
@@ -119,27 +117,14 @@ String lookup_module(StringRef const& module_path, Array<String> const& paths) {
     return "";
 }
 
-Module* process_file(StringRef const& modulepath, Array<String> const& paths) {
-    String filepath = lookup_module(modulepath, paths);
-    if (filepath.empty()) {
-        return nullptr;
-    }
-
-    FileBuffer buffer(filepath);
-    Lexer      lexer(buffer);
-    Parser     parser(lexer);
-    Module*    mod = parser.parse_module();
-    return mod;
-}
-
 TypeExpr* SemanticAnalyser::import(Import* n, int depth) {
     // import datetime, time
     // import math as m
     for (auto& name: n->names) {
-        StringRef nm  = name.name;
-        auto*     mod = process_file(name.name, paths);
+        StringRef           nm     = name.name;
+        ImportedModule loaded = ModuleRegistry::instance().import(name.name, paths);
 
-        if (mod == nullptr) {
+        if (!loaded.found) {
             SEMA_ERROR(n, ModuleNotFoundError, name.name);
             continue;
         }
@@ -148,21 +133,8 @@ TypeExpr* SemanticAnalyser::import(Import* n, int depth) {
             nm = name.asname.value();
         }
 
-        // Check ownership of Module
-        // we could make the import statement the owner
-        // but it could be imported multiple times
-        // in that case we would like to avoid doing SEMA
-        // and reuse the same version
-        // we could also import modules using multiple threads
-        // so we will need a place to manage all those modules
-        // sounds like shared_ptr might the easiest
-        // mod->move(n);
-
-        // TODO: this needs to be kept somewhere
-        SemanticAnalyser sema;
-        sema.exec(mod, 0);
-
-        bindings.add(nm, mod, lython::Module_t());
+        // the registry owns the module, it is shared by all the imports
+        bindings.add(nm, loaded.module, lython::Module_t());
     }
     return nullptr;
 }
@@ -215,31 +187,37 @@ StmtNode* find(Array<StmtNode*> const& body, StringRef const& name) {
 }
 
 TypeExpr* SemanticAnalyser::importfrom(ImportFrom* n, int depth) {
-    Module* mod = nullptr;
+    ImportedModule loaded;
 
     // Regular import using system path
     if (n->module.has_value() && !n->level.has_value()) {
-        mod = process_file(n->module.value(), paths);
+        loaded = ModuleRegistry::instance().import(n->module.value(), paths);
 
-        if (mod == nullptr) {
+        if (!loaded.found) {
             SEMA_ERROR(n, ModuleNotFoundError, n->module.value());
             return nullptr;
         }
     } else if (n->level.has_value()) {
         // relative import using level
 
-        if (mod == nullptr) {
+        if (!loaded.found) {
             SEMA_ERROR(n, ModuleNotFoundError, n->module.value());
             return nullptr;
         }
     }
 
-    // TODO: Someone must be the owner of module
-    // mod->move(n);
+    if (!loaded.found) {
+        return nullptr;
+    }
 
-    // TODO: this needs to be kept somewhere
-    SemanticAnalyser sema;
-    sema.exec(mod, 0);
+    // another thread is analysing the module, its names are not known yet
+    if (loaded.module == nullptr) {
+        for (auto& name: n->names) {
+            StringRef nm = name.asname.has_value() ? name.asname.value() : name.name;
+            bindings.add(nm, nullptr, nullptr);
+        }
+        return nullptr;
+    }
 
     for (auto& name: n->names) {
         StringRef nm = name.name;
@@ -247,15 +225,18 @@ TypeExpr* SemanticAnalyser::importfrom(ImportFrom* n, int depth) {
         // lookup name.name inside module;
         // functions, classes are stmt
         // but variable could also be imported which are expressions
-        StmtNode* value = find(mod->body, nm);
+        StmtNode* value = find(loaded.module->body, nm);
 
         if (value == nullptr) {
             debug("{} not found", nm);
             continue;
         }
 
-        auto  varid = sema.bindings.get_varid(nm);
-        auto* type  = sema.bindings.get_type(varid);
+        // a circular import gets the module before it is analysed
+        TypeExpr* type = nullptr;
+        if (loaded.bindings != nullptr) {
+            type = loaded.bindings->get_type(loaded.bindings->get_varid(nm));
+        }
 
         // Did not find the value inside the module
         if (value == nullptr) {
@@ -0,0 +1,168 @@
+#include "sema/sema.h"
+#include "utilities/guard.h"
+#include "utilities/pool.h"
+
+#include <algorithm>
+#include <exception>
+#include <future>
+
+namespace lython {
+
+namespace {
+
+using SemaErrors = Array<std::unique_ptr<SemaException>>;
+
+// Analyse the bodies [begin, end) with their own analyser.
+// The bodies are in source order, the bindings they see only grow so the analyser
+// catches up with the bindings of the module instead of copying them for each body
+void analyse_bodies(SemanticAnalyser const&    module,
+                    Array<DeferredBody> const& bodies,
+                    std::size_t                begin,
+                    std::size_t                end,
+                    Array<SemaErrors>&         errors) {
+    SemanticAnalyser sema;
+    sema.paths    = module.paths;
+    sema.flags    = module.flags;
+    sema.bindings = module.bindings;
+    sema.bindings.truncate(bodies[begin].globals);
+
+    for (std::size_t i = begin; i < end; i++) {
+        DeferredBody const& body = bodies[i];
+        FunctionDef*        fun  = body.fun;
+
+        sema.bindings.extend(module.bindings, body.globals);
+        sema.bindings.global_index = body.global_index;
+
+        {
+            PopGuard _(sema.namespaces, str(fun->name));
+            PopGuard nested(sema.nested, (StmtNode*)fun);
+            Scope    scope(sema.bindings);
+
+            for (BindingEntry const& arg: body.arguments) {
+                sema.bindings.add(arg.name, arg.value, arg.type);
+            }
+
+            sema.functiondef_body(fun, body.type, body.depth);
+        }
+
+        errors[i] = std::move(sema.errors);
+        sema.errors.clear();
+    }
+}
+
+// The first body assigning an attribute without a type sets it on the class, the later ones
+// are checked against it. The classes are shared by the workers, if one of them has such
+// an attribute the bodies need to run in source order
+bool has_untyped_attributes(Bindings const& bindings) {
+    for (BindingEntry const& entry: bindings.bindings) {
+        ClassDef* cls = cast<ClassDef>(entry.value);
+        if (cls == nullptr) {
+            continue;
+        }
+
+        // see attribute_assign(), the first attribute is never updated
+        for (std::size_t i = 1; i < cls->attributes.size(); i++) {
+            if (cls->attributes[i].type == nullptr) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+}  // namespace
+
+void SemanticAnalyser::exec_parallel(Module* mod, ThreadPool& pool) {
+    // a single worker would only add overhead, and nodes allocated on the heap
+    // are added to the children of their parent which the workers cannot do concurrently
+    if (pool.size() <= 1 || mod->arena == nullptr) {
+        exec(mod, 0);
+        return;
+    }
+
+    // Forward pass, everything but the bodies of the top level functions
+    deferred.clear();
+    forwardpass = true;
+    exec(mod, 0);
+    forwardpass = false;
+
+    Array<DeferredBody> bodies = std::move(deferred);
+    deferred.clear();
+
+    if (bodies.empty()) {
+        return;
+    }
+
+    // the workers allocate the nodes they create from the arenas of the module
+    Array<Arena*> arenas;
+    if (mod->arena) {
+        arenas.push_back(mod->arena.get());
+    }
+    for (Unique<Arena>& arena: mod->arenas) {
+        arenas.push_back(arena.get());
+    }
+    for (Arena* arena: arenas) {
+        arena->set_shared(true);
+    }
+
+    // a few batches per worker to even out the size of the functions
+    std::size_t batches = std::min(bodies.size(), pool.size() * 4);
+    if (has_untyped_attributes(bindings)) {
+        batches = 1;
+    }
+
+    Array<SemaErrors> body_errors(bodies.size());
+
+    // The pool copies the result of the tasks
+    Array<std::future<std::exception_ptr>> futures;
+    futures.reserve(batches);
+
+    for (std::size_t b = 0; b < batches; b++) {
+        std::size_t begin = bodies.size() * b / batches;
+        std::size_t end   = bodies.size() * (b + 1) / batches;
+
+        futures.push_back(pool.queue_task([this, &bodies, &body_errors, begin, end]() {
+            try {
+                analyse_bodies(*this, bodies, begin, end, body_errors);
+            } catch (...) { return std::current_exception(); }
+            return std::exception_ptr();
+        }));
+    }
+
+    // the tasks use the bodies, all of them need to be done before raising
+    std::exception_ptr failure;
+    for (auto& future: futures) {
+        std::exception_ptr result = future.get();
+        if (result && !failure) {
+            failure = result;
+        }
+    }
+
+    for (Arena* arena: arenas) {
+        arena->set_shared(false);
+    }
+
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+
+    // Merge the errors in the order the serial analysis finds them
+    SemaErrors  merged;
+    std::size_t k = 0;
+
+    for (std::size_t i = 0; i < bodies.size(); i++) {
+        for (; k < bodies[i].error; k++) {
+            merged.push_back(std::move(errors[k]));
+        }
+        for (auto& error: body_errors[i]) {
+            merged.push_back(std::move(error));
+        }
+    }
+    for (; k < errors.size(); k++) {
+        merged.push_back(std::move(errors[k]));
+    }
+
+    errors = std::move(merged);
+}
+
+}  // namespace lython
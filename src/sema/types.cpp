@@ -0,0 +1,365 @@
+#include "sema/types.h"
+#include "ast/ops.h"
+#include "dependencies/xx_hash.h"
+
+#include <algorithm>
+#include <mutex>
+
+namespace lython {
+
+namespace {
+
+// Canonical children of the composites being interned by this thread,
+// nested composites push theirs on top; the lookups reuse it instead of building a key
+thread_local Array<TypeExpr*> pending;
+
+bool is_leaf(TypeExpr const* type) {
+    return type->kind == NodeKind::Name || type->kind == NodeKind::BuiltinType;
+}
+
+StringRef identifier(TypeExpr const* type) {
+    if (type->kind == NodeKind::Name) {
+        return static_cast<Name const*>(type)->id;
+    }
+    return static_cast<BuiltinType const*>(type)->name;
+}
+
+uint64 hash(NodeKind kind, TypeExpr* const* children, std::size_t count) {
+    uint64 h = xx_hash_3(children, count * sizeof(TypeExpr*));
+    return h ^ ((uint64(kind) << 32 | uint64(count)) * 0x9E3779B97F4A7C15ull);
+}
+
+bool matches(TypeExpr const* type, NodeKind kind, TypeExpr* const* children, std::size_t count) {
+    if (type->kind != kind) {
+        return false;
+    }
+
+    auto same_children = [&](Array<ExprNode*> const& elts, std::size_t n) {
+        if (elts.size() != n) {
+            return false;
+        }
+        return std::equal(elts.begin(), elts.end(), children);
+    };
+
+    switch (kind) {
+    case NodeKind::ArrayType: return static_cast<ArrayType const*>(type)->value == children[0];
+    case NodeKind::SetType: return static_cast<SetType const*>(type)->value == children[0];
+    case NodeKind::DictType: {
+        DictType const* dict = static_cast<DictType const*>(type);
+        return dict->key == children[0] && dict->value == children[1];
+    }
+    case NodeKind::TupleType:
+        return same_children(static_cast<TupleType const*>(type)->types, count);
+    case NodeKind::Arrow: {
+        Arrow const* arrow = static_cast<Arrow const*>(type);
+        return arrow->returns == children[count - 1] && same_children(arrow->args, count - 1);
+    }
+    default: return false;
+    }
+}
+
+}  // namespace
+
+TypeInterner& TypeInterner::instance() {
+    static TypeInterner types;
+    return types;
+}
+
+TypeInterner::TypeInterner() { _root.enable_arena(); }
+
+std::size_t TypeInterner::size() const {
+    std::shared_lock<std::shared_mutex> lock(_mutex);
+    return std::size_t(_count);
+}
+
+TypeExpr* TypeInterner::leaf(NodeKind kind, StringRef name) {
+    // identifiers are indices in the string database, they leave the top bits free
+    uint64 k = (uint64(kind) << 48) | name.__id__();
+
+    {
+        std::shared_lock<std::shared_mutex> lock(_mutex);
+
+        auto result = _leaves.find(k);
+        if (result != _leaves.end()) {
+            return result->second;
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(_mutex);
+
+    // another thread could have inserted it while the lock was released
+    TypeExpr*& type = _leaves[k];
+    if (type != nullptr) {
+        return type;
+    }
+
+    if (kind == NodeKind::Name) {
+        Name* ref = _root.new_object<Name>();
+        ref->id   = name;
+        ref->ctx  = ExprContext::Load;
+        type      = ref;
+    } else {
+        BuiltinType* builtin = _root.new_object<BuiltinType>();
+        builtin->name        = name;
+        type                 = builtin;
+    }
+
+    insert(type);
+    return type;
+}
+
+TypeExpr* TypeInterner::name(StringRef name) { return leaf(NodeKind::Name, name); }
+
+bool TypeInterner::push(TypeExpr* child) {
+    TypeExpr* canon = nullptr;
+    if (!intern(child, canon)) {
+        return false;
+    }
+    pending.push_back(canon);
+    return true;
+}
+
+bool TypeInterner::intern(TypeExpr* type, TypeExpr*& out) {
+    if (type == nullptr || canonical(type)) {
+        out = type;
+        return true;
+    }
+
+    // locals are not interned, the same name could refer to another binding where it is used
+    if (type->kind == NodeKind::Name && static_cast<Name*>(type)->dynamic) {
+        return false;
+    }
+
+    if (is_leaf(type)) {
+        out = leaf(type->kind, identifier(type));
+        return true;
+    }
+
+    std::size_t base = pending.size();
+    bool        ok   = true;
+
+    switch (type->kind) {
+    case NodeKind::ArrayType: ok = push(static_cast<ArrayType*>(type)->value); break;
+    case NodeKind::SetType: ok = push(static_cast<SetType*>(type)->value); break;
+    case NodeKind::DictType: {
+        DictType* dict = static_cast<DictType*>(type);
+        ok             = push(dict->key) && push(dict->value);
+        break;
+    }
+    case NodeKind::TupleType: {
+        for (TypeExpr* elt: static_cast<TupleType*>(type)->types) {
+            if (!(ok = push(elt))) {
+                break;
+            }
+        }
+        break;
+    }
+    case NodeKind::Arrow: {
+        Arrow* arrow = static_cast<Arrow*>(type);
+        for (TypeExpr* arg: arrow->args) {
+            if (!(ok = push(arg))) {
+                break;
+            }
+        }
+        ok = ok && push(arrow->returns);
+        break;
+    }
+    default: return false;
+    }
+
+    if (!ok) {
+        pending.resize(base);
+        return false;
+    }
+
+    out = composite(type->kind, base);
+    return true;
+}
+
+TypeExpr* TypeInterner::find(uint64           h,
+                             NodeKind         kind,
+                             TypeExpr* const* children,
+                             std::size_t      count) const {
+    auto bucket = _composites.find(h);
+    if (bucket == _composites.end()) {
+        return nullptr;
+    }
+
+    for (TypeExpr* type: bucket->second) {
+        if (matches(type, kind, children, count)) {
+            return type;
+        }
+    }
+    return nullptr;
+}
+
+TypeExpr* TypeInterner::composite(NodeKind kind, std::size_t base) {
+    TypeExpr* const* children = pending.data() + base;
+    std::size_t      count    = pending.size() - base;
+    uint64           h        = hash(kind, children, count);
+    TypeExpr*        type     = nullptr;
+
+    {
+        std::shared_lock<std::shared_mutex> lock(_mutex);
+        type = find(h, kind, children, count);
+    }
+
+    if (type == nullptr) {
+        std::unique_lock<std::shared_mutex> lock(_mutex);
+
+        type = find(h, kind, children, count);
+        if (type == nullptr) {
+            type = make(kind, children, count);
+            _composites[h].push_back(type);
+            insert(type);
+        }
+    }
+
+    pending.resize(base);
+    return type;
+}
+
+TypeExpr* TypeInterner::make(NodeKind kind, TypeExpr* const* children, std::size_t count) {
+    switch (kind) {
+    case NodeKind::ArrayType: {
+        ArrayType* type = _root.new_object<ArrayType>();
+        type->value     = children[0];
+        return type;
+    }
+    case NodeKind::SetType: {
+        SetType* type = _root.new_object<SetType>();
+        type->value   = children[0];
+        return type;
+    }
+    case NodeKind::DictType: {
+        DictType* type = _root.new_object<DictType>();
+        type->key      = children[0];
+        type->value    = children[1];
+        return type;
+    }
+    case NodeKind::TupleType: {
+        TupleType* type = _root.new_object<TupleType>();
+        type->types.assign(children, children + count);
+        return type;
+    }
+    case NodeKind::Arrow: {
+        Arrow* type = _root.new_object<Arrow>();
+        type->args.assign(children, children + count - 1);
+        type->returns = children[count - 1];
+        return type;
+    }
+    default: return nullptr;
+    }
+}
+
+int TypeInterner::id(TypeExpr* type) {
+    TypeExpr* canon = nullptr;
+    if (!intern(type, canon)) {
+        return -1;
+    }
+    if (canon == nullptr) {
+        return 0;
+    }
+
+    std::shared_lock<std::shared_mutex> lock(_mutex);
+    return _ids.at(canon);
+}
+
+TypeExpr* TypeInterner::array(Node* parent, TypeExpr* value) {
+    std::size_t base = pending.size();
+    if (push(value)) {
+        return composite(NodeKind::ArrayType, base);
+    }
+
+    ArrayType* type = parent->new_object<ArrayType>();
+    type->value     = value;
+    return type;
+}
+
+TypeExpr* TypeInterner::set(Node* parent, TypeExpr* value) {
+    std::size_t base = pending.size();
+    if (push(value)) {
+        return composite(NodeKind::SetType, base);
+    }
+
+    SetType* type = parent->new_object<SetType>();
+    type->value   = value;
+    return type;
+}
+
+TypeExpr* TypeInterner::dict(Node* parent, TypeExpr* key, TypeExpr* value) {
+    std::size_t base = pending.size();
+    if (push(key) && push(value)) {
+        return composite(NodeKind::DictType, base);
+    }
+    pending.resize(base);
+
+    DictType* type = parent->new_object<DictType>();
+    type->key      = key;
+    type->value    = value;
+    return type;
+}
+
+TypeExpr* TypeInterner::tuple(Node* parent, Array<TypeExpr*> const& types) {
+    std::size_t base = pending.size();
+    bool        ok   = true;
+
+    for (TypeExpr* elt: types) {
+        if (!(ok = push(elt))) {
+            break;
+        }
+    }
+    if (ok) {
+        return composite(NodeKind::TupleType, base);
+    }
+    pending.resize(base);
+
+    TupleType* type = parent->new_object<TupleType>();
+    type->types     = types;
+    return type;
+}
+
+Arrow* TypeInterner::arrow(Node* parent, Array<TypeExpr*> const& args, TypeExpr* returns) {
+    std::size_t base = pending.size();
+    bool        ok   = true;
+
+    for (TypeExpr* arg: args) {
+        if (!(ok = push(arg))) {
+            break;
+        }
+    }
+    if (ok && push(returns)) {
+        return static_cast<Arrow*>(composite(NodeKind::Arrow, base));
+    }
+    pending.resize(base);
+
+    Arrow* type   = parent->new_object<Arrow>();
+    type->args    = args;
+    type->returns = returns;
+    return type;
+}
+
+bool TypeInterner::same(TypeExpr* a, TypeExpr* b) {
+    if (a == nullptr || b == nullptr) {
+        return a == b;
+    }
+
+    if (canonical(a) && canonical(b)) {
+        return a == b;
+    }
+
+    // names and builtin types are compared by identifier, without looking them up
+    if (is_leaf(a) && is_leaf(b)) {
+        return a->kind == b->kind && identifier(a) == identifier(b);
+    }
+
+    TypeExpr* i = nullptr;
+    TypeExpr* j = nullptr;
+
+    if (!intern(a, i) || !intern(b, j)) {
+        return equal(a, b);
+    }
+    return i == j;
+}
+
+}  // namespace lython
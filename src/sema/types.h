@@ -0,0 +1,92 @@
+#ifndef LYTHON_SEMA_TYPES_HEADER
+#define LYTHON_SEMA_TYPES_HEADER
+
+#include <shared_mutex>
+
+#include "sema/builtin.h"
+
+namespace lython {
+
+/*
+ *  Hash-consing of the types deduced by SEM-A
+ *
+ *  Structurally equal types share a single canonical instance, 0 is the id of the missing type.
+ *  The store is shared by every module and every analyser of the program, a type deduced
+ *  in one module is the same instance as the one deduced by an import or by another thread.
+ *  Canonical instances are allocated from the arena of the store, they live as long as
+ *  the program and are never modified: comparing two of them is a pointer compare.
+ *
+ *  The children of a canonical type are canonical. Names and builtin types are leaves
+ *  looked up by their identifier, the canonical names are not bound to a variable (varid is -1),
+ *  the analyser resolves them in the global scope. References to a local binding are
+ *  not interned for that reason. Containers and arrows are looked up by the hash
+ *  of their canonical children, the lookup does not allocate.
+ *
+ *  Types follow the rules of equal(): names are compared by identifier,
+ *  arrows by arguments and return type. Expressions that are not types
+ *  (subscripts, attributes, class types...) cannot be interned and are compared with equal(),
+ *  the containers made of them are allocated by the node that deduced them.
+ *
+ *  Lookups take a shared lock, only the insertion of a new type is exclusive.
+ */
+class TypeInterner {
+    public:
+    static TypeInterner& instance();
+
+    // Id of the type, -1 if it cannot be interned
+    int id(TypeExpr* type);
+
+    // Canonical reference to a type by its name
+    TypeExpr* name(StringRef name);
+
+    // Canonical container types, allocated by parent if one of their children cannot be interned
+    TypeExpr* array(Node* parent, TypeExpr* value);
+    TypeExpr* set(Node* parent, TypeExpr* value);
+    TypeExpr* dict(Node* parent, TypeExpr* key, TypeExpr* value);
+    TypeExpr* tuple(Node* parent, Array<TypeExpr*> const& types);
+    Arrow*    arrow(Node* parent, Array<TypeExpr*> const& args, TypeExpr* returns);
+
+    bool same(TypeExpr* a, TypeExpr* b);
+
+    bool canonical(TypeExpr const* type) const {
+        return type != nullptr && type->get_parent() == &_root;
+    }
+
+    // Number of distinct types, the missing type included
+    std::size_t size() const;
+
+    TypeInterner(TypeInterner const&) = delete;
+    TypeInterner& operator=(TypeInterner const&) = delete;
+
+    private:
+    TypeInterner();
+
+    // Canonical instance of type, false if it cannot be interned
+    bool intern(TypeExpr* type, TypeExpr*& out);
+
+    TypeExpr* leaf(NodeKind kind, StringRef name);
+
+    // Intern child on top of the children of the composite being interned
+    bool push(TypeExpr* child);
+
+    // Canonical composite made of the children pushed since base, pops them
+    TypeExpr* composite(NodeKind kind, std::size_t base);
+
+    TypeExpr* find(uint64 hash, NodeKind kind, TypeExpr* const* children, std::size_t count) const;
+
+    TypeExpr* make(NodeKind kind, TypeExpr* const* children, std::size_t count);
+
+    void insert(TypeExpr* type) { _ids[type] = _count++; }
+
+    mutable std::shared_mutex _mutex;
+
+    Module                         _root;        // owns the canonical types, from its arena
+    Dict<uint64, TypeExpr*>        _leaves;      // kind and identifier -> canonical type
+    Dict<uint64, Array<TypeExpr*>> _composites;  // hash of kind and children -> canonical types
+    Dict<TypeExpr const*, int>     _ids;         // canonical type -> id
+    int                            _count = 1;   // the missing type
+};
+
+}  // namespace lython
+
+#endif
@@ -89,8 +89,14 @@ bool CPU::free(void* ptr, std::size_t) {
 void show_alloc_stats() {
     metadata_init_names();
 
-    auto const&                                 stat  = meta::stats();
-    std::unordered_map<int, std::string> const& names = meta::typenames();
+    // printing allocates, which can register types
+    std::unordered_map<int, std::string> names;
+    {
+        std::lock_guard<std::mutex> lock(meta::TypeRegistry::instance().mutex);
+        names = meta::typenames();
+    }
+
+    auto const& stat = meta::stats();
 
     auto line = String(4 + 40 + 10 + 10 + 10 + 10 + 10 + 10 + 7 + 1, '-');
 
@@ -114,12 +120,12 @@ void show_alloc_stats() {
             name = names.at(int(i));
         } catch (std::out_of_range&) { name = ""; }
 
-        auto init      = stat[i].startup_count;
-        auto alloc     = stat[i].allocated - init;
-        auto dealloc   = stat[i].deallocated;
-        auto size      = stat[i].size_alloc;
-        auto size_free = stat[i].size_free;
-        auto bytes     = stat[i].bytes;
+        int init      = stat[i].startup_count;
+        int alloc     = stat[i].allocated - init;
+        int dealloc   = stat[i].deallocated;
+        int size      = stat[i].size_alloc;
+        int size_free = stat[i].size_free;
+        int bytes     = stat[i].bytes;
 
         total += size * bytes;
 
@@ -144,7 +150,6 @@ void show_alloc_stats() {
            "which means it does not necessarily means there is a memory leak.\n"
            "use valgrind to make sure everything is released properly.\n"
            "\n"
-           "* Pair[String, NativeBinaryOp]: Native operator, allocated once using static\n"
            "* Pair[StringView, size_t]: From the string database, allocated once using static\n"
            "* Constant: builtin constant created once using static\n"
            "\n----\n";
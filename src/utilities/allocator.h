@@ -1,8 +1,11 @@
 #ifndef LYTHON_UTILITIES_ALLOCATOR_HEADER
 #define LYTHON_UTILITIES_ALLOCATOR_HEADER
 
+#include <atomic>
 #include <functional>
 #include <memory>
+#include <mutex>
+#include <stdexcept>
 #include <unordered_map>
 #include <vector>
 
@@ -16,23 +19,57 @@ namespace meta {
 
 // NOTE: All those should not depend on each other during deinit time
 // https://isocpp.org/wiki/faq/ctors#construct-on-first-use-v2
+// The counters are updated by the threads allocating, without the lock
 struct Stat {
-    int allocated     = 0;
-    int deallocated   = 0;
-    int bytes         = 0;
-    int size_alloc    = 0;
-    int size_free     = 0;
-    int startup_count = 0;
+    std::atomic<int> allocated{0};
+    std::atomic<int> deallocated{0};
+    std::atomic<int> bytes{0};
+    std::atomic<int> size_alloc{0};
+    std::atomic<int> size_free{0};
+    std::atomic<int> startup_count{0};
+};
+
+// Stats of each type, allocated by chunks so they never move once created
+class StatTable {
+    public:
+    static constexpr std::size_t chunk_size = 256;
+    static constexpr std::size_t max_chunks = 64;
+
+    std::size_t size() const { return _size.load(std::memory_order_acquire); }
+
+    Stat&       operator[](std::size_t i) { return _chunks[i / chunk_size][i % chunk_size]; }
+    Stat const& operator[](std::size_t i) const { return _chunks[i / chunk_size][i % chunk_size]; }
+
+    // called with the registry lock held
+    void push_back() {
+        std::size_t i     = _size.load(std::memory_order_relaxed);
+        std::size_t chunk = i / chunk_size;
+
+        if (chunk >= max_chunks) {
+            throw std::length_error("Too many types registered");
+        }
+        if (i % chunk_size == 0) {
+            _chunks[chunk].reset(new Stat[chunk_size]);
+        }
+        _size.store(i + 1, std::memory_order_release);
+    }
+
+    private:
+    std::unique_ptr<Stat[]>  _chunks[max_chunks];
+    std::atomic<std::size_t> _size{0};
 };
 
 bool& is_type_registry_available();
 
 struct TypeRegistry {
-    std::vector<Stat>                    stat;
+    StatTable                            stat;
     bool                                 print_stats = false;
     std::unordered_map<int, std::string> id_to_name;
     int                                  type_counter = 0;
 
+    // types can be registered by the first thread using them
+    std::mutex mutex;
+
     static TypeRegistry& instance() {
         static TypeRegistry obj;
         return obj;
@@ -49,14 +86,16 @@ struct TypeRegistry {
     }
 };
 
-inline std::vector<Stat>& stats() { return TypeRegistry::instance().stat; }
+inline StatTable& stats() { return TypeRegistry::instance().stat; }
 
 inline int& _get_id() { return TypeRegistry::instance().type_counter; }
 
 inline int _new_id() {
+    std::lock_guard<std::mutex> lock(TypeRegistry::instance().mutex);
+
     auto r = _get_id();
     _get_id() += 1;
-    stats().push_back(Stat());
+    stats().push_back();
     return r;
 }
 
@@ -76,8 +115,10 @@ int _register_type_once(const char* str) {
     if (!is_type_registry_available())
         return 0;
 
-    auto tid    = type_id<T>();
-    auto result = typenames().find(tid);
+    auto tid = type_id<T>();
+
+    std::lock_guard<std::mutex> lock(TypeRegistry::instance().mutex);
+    auto                        result = typenames().find(tid);
 
     if (result == typenames().end()) {
         typenames().insert({type_id<T>(), str});
@@ -96,20 +137,31 @@ const char* register_type(const char* str) {
 // You can specialize it to override
 template <typename T>
 const char* type_name() {
-    auto result = typenames().find(type_id<T>());
+    auto tid = type_id<T>();
 
-    if (result == typenames().end()) {
-        const char* name = typeid(T).name();
-        register_type<T>(name);
-        return "<none>";
+    {
+        // names are never modified once inserted, they can be used without the lock
+        std::lock_guard<std::mutex> lock(TypeRegistry::instance().mutex);
+        auto                        result = typenames().find(tid);
+
+        if (result != typenames().end()) {
+            return (result->second).c_str();
+        }
     }
 
-    return (result->second).c_str();
+    const char* name = typeid(T).name();
+    register_type<T>(name);
+    return "<none>";
 };
 
 inline const char* type_name(int class_id) {
-    std::string const& name = typenames()[class_id];
-    return name.c_str();
+    std::lock_guard<std::mutex> lock(TypeRegistry::instance().mutex);
+    auto                        result = typenames().find(class_id);
+
+    if (result == typenames().end()) {
+        return "";
+    }
+    return (result->second).c_str();
 };
 
 template <typename T>
@@ -152,8 +204,9 @@ struct CPU: public DeviceAllocatorTrait<CPU> {
 }  // namespace device
 
 inline void manual_free(int class_id, std::size_t n) {
-    meta::get_stat(class_id).deallocated += 1;
-    meta::get_stat(class_id).size_free += int(n);
+    meta::Stat& stat = meta::get_stat(class_id);
+    stat.deallocated.fetch_add(1, std::memory_order_relaxed);
+    stat.size_free.fetch_add(int(n), std::memory_order_relaxed);
 }
 
 template <typename T, typename Device>
@@ -189,9 +242,10 @@ class Allocator {
 
     static T* allocate(std::size_t n, const void* = nullptr) {
         meta::register_type<T>(typeid(T).name());
-        meta::get_stat<T>().allocated += 1;
-        meta::get_stat<T>().size_alloc += int(n);
-        meta::get_stat<T>().bytes = int(sizeof(T));
+        meta::Stat& stat = meta::get_stat<T>();
+        stat.allocated.fetch_add(1, std::memory_order_relaxed);
+        stat.size_alloc.fetch_add(int(n), std::memory_order_relaxed);
+        stat.bytes.store(int(sizeof(T)), std::memory_order_relaxed);
         return static_cast<T*>(Device::malloc(n * sizeof(T)));
     }
 
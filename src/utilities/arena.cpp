@@ -0,0 +1,38 @@
+#include "utilities/arena.h"
+
+#include <algorithm>
+
+namespace lython {
+
+Arena::~Arena() {
+    Finalizer* fin = _finalizers;
+    while (fin != nullptr) {
+        Finalizer* next = fin->next;
+        fin->destroy(fin + 1);
+        fin = next;
+    }
+
+    while (_block != nullptr) {
+        char* previous = *reinterpret_cast<char**>(_block);
+        device::CPU::free(_block, 0);
+        _block = previous;
+    }
+}
+
+void Arena::grow(std::size_t min_size) {
+    std::size_t header = alignof(std::max_align_t);
+    std::size_t size   = std::max(_block_size, min_size + header);
+
+    char* block = static_cast<char*>(device::CPU::malloc(size));
+    if (block == nullptr) {
+        throw std::bad_alloc();
+    }
+
+    *reinterpret_cast<char**>(block) = _block;
+
+    _block    = block;
+    _capacity = size;
+    _used     = header;
+}
+
+}  // namespace lython
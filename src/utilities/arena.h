@@ -0,0 +1,106 @@
+#ifndef LYTHON_UTILITIES_ARENA_HEADER
+#define LYTHON_UTILITIES_ARENA_HEADER
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <utility>
+
+#include "utilities/allocator.h"
+
+namespace lython {
+
+// Bump pointer region, memory is handed out from large blocks
+// and everything is released at once when the arena is destroyed.
+//
+// Objects created with make<T>() have their destructor called on release,
+// in the reverse order of their creation
+//
+// An arena is not thread-safe unless it is marked as shared,
+// allocations then take a lock
+class Arena {
+    public:
+    Arena(std::size_t block_size = 64 * 1024): _block_size(block_size) {}
+
+    ~Arena();
+
+    Arena(Arena const&) = delete;
+    Arena& operator=(Arena const&) = delete;
+
+    // align needs to be a power of 2
+    void* allocate(std::size_t size, std::size_t align = alignof(std::max_align_t)) {
+        std::unique_lock<std::mutex> lock(_mutex, std::defer_lock);
+        if (_shared) {
+            lock.lock();
+        }
+        return bump(size, align);
+    }
+
+    template <typename T, typename... Args>
+    T* make(Args&&... args) {
+        std::unique_lock<std::mutex> lock(_mutex, std::defer_lock);
+        if (_shared) {
+            lock.lock();
+        }
+
+        Finalizer* fin = static_cast<Finalizer*>(bump(sizeof(Finalizer) + sizeof(T), alignof(Finalizer)));
+        static_assert(alignof(T) <= alignof(Finalizer), "Finalizer does not align T");
+
+        T* obj = new ((void*)(fin + 1)) T(std::forward<Args>(args)...);
+
+        fin->destroy = [](void* ptr) { static_cast<T*>(ptr)->~T(); };
+        fin->next    = _finalizers;
+        _finalizers  = fin;
+        return obj;
+    }
+
+    // Bytes handed out so far
+    std::size_t allocated() const { return _allocated; }
+
+    // Lock the allocations while the arena is used by several threads
+    void set_shared(bool shared) { _shared = shared; }
+
+    private:
+    struct alignas(std::max_align_t) Finalizer {
+        Finalizer* next;
+        void (*destroy)(void*);
+    };
+
+    void* bump(std::size_t size, std::size_t align) {
+        std::size_t offset = aligned_offset(align);
+
+        if (_block == nullptr || offset + size > _capacity) {
+            grow(size + align);
+            offset = aligned_offset(align);
+        }
+
+        _used = offset + size;
+        _allocated += size;
+        return _block + offset;
+    }
+
+    void grow(std::size_t min_size);
+
+    std::size_t aligned_offset(std::size_t align) const {
+        auto address = reinterpret_cast<std::uintptr_t>(_block) + _used;
+        return _used + (((address + align - 1) & ~(align - 1)) - address);
+    }
+
+    // blocks are chained, the first bytes of a block point to the previous one
+    char*       _block    = nullptr;
+    std::size_t _capacity = 0;
+    std::size_t _used     = 0;
+
+    std::size_t _block_size;
+    std::size_t _allocated = 0;
+
+    Finalizer* _finalizers = nullptr;
+
+    std::mutex _mutex;
+    bool       _shared = false;
+};
+
+}  // namespace lython
+
+#endif
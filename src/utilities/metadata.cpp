@@ -112,14 +112,6 @@ bool _metadata_init_names() {
     meta::register_type<HashNodeInternal<std::pair<const StringRef, lython::ExprNode*>, true>>(
         "Pair[String, ExprNode*]");
 
-    meta::register_type<
-        HashNodeInternal<std::pair<const StringRef, lython::BinOp::NativeBinaryOp>, true>>(
-        "Pair[String, NativeBinaryOp]");
-
-    meta::register_type<
-        HashNodeInternal<std::pair<const StringRef, lython::UnaryOp::NativeUnaryOp>, true>>(
-        "Pair[String, NativeUnaryOp]");
-
     // String Database
     meta::register_type<Array<StringDatabase::StringEntry>*>("Array[StringEntry]*");
 
@@ -141,14 +133,6 @@ bool _metadata_init_names() {
     meta::register_type<ListIterator<std::pair<const String, TokenType>, false>>(
         "Iterator[Pair[String, TokenType]]");
 
-    meta::register_type<
-        ListIterator<std::pair<const StringRef, lython::BinOp::NativeBinaryOp>, false>>(
-        "Iterator[Pair[StringRef, NativeBinaryOp]]");
-
-    meta::register_type<
-        ListIterator<std::pair<const StringRef, lython::UnaryOp::NativeUnaryOp>, false>>(
-        "Iterator[Pair[StringRef, NativeUnaryOp]]");
-
     meta::register_type<ListIterator<std::pair<const StringRef, lython::ExprNode*>, false>>(
         "Iterator[Pair[StringRef, ExprNode*]]");
 
@@ -168,14 +152,6 @@ bool _metadata_init_names() {
     meta::register_type<HashNodeInternal<std::pair<const StringRef, lython::ExprNode*>, false>>(
         "Pair[StringRef, ExprNode*]");
 
-    meta::register_type<
-        HashNodeInternal<std::pair<const StringRef, lython::BinOp::NativeBinaryOp>, false>>(
-        "Pair[StringRef, NativeBinaryOp]");
-
-    meta::register_type<
-        HashNodeInternal<std::pair<const StringRef, lython::UnaryOp::NativeUnaryOp>, false>>(
-        "Pair[StringRef, NativeUnaryOp]");
-
     meta::register_type<HashNodeInternal<std::pair<const StringRef, bool>, false>>(
         "Pair[StringRef, bool]");
 
@@ -209,8 +185,8 @@ void track_static() {
     // this will only work if `metadata_init_names` is called
     // after the static variables got initialized
     auto& stat = meta::stats();
-    for (auto& s: stat) {
-        s.startup_count = 0;
+    for (std::size_t i = 0; i < stat.size(); i++) {
+        stat[i].startup_count = 0;
         // s.allocated - s.deallocated;
     }
 }
@@ -227,10 +203,6 @@ void register_globals() {
             default_precedence();
             keywords();
             keyword_as_string();
-            native_binary_operators();
-            native_bool_operators();
-            native_unary_operators();
-            native_cmp_operators();
             operator_magic_name(BinaryOperator::Add);
             operator_magic_name(BoolOperator::And);
             operator_magic_name(UnaryOperator::Invert);
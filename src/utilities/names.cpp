@@ -103,7 +103,7 @@ std::size_t StringDatabase::inc(std::size_t i) {
     }
 
     if (i >= size) {
-        debug("Critical error {} < {}", i, size);
+        debug("Critical error {} < {}", i, size.load());
         return 0;
     }
 
@@ -125,7 +125,7 @@ Array<StringDatabase::StringEntry>& StringDatabase::current_block() {
     return newblock();
 }
 
-StringRef StringDatabase::string(String const& name) {
+StringRef StringDatabase::string(StringView name) {
     COZ_BEGIN("T::StringDatabase::string");
     auto str = lookup_or_insert_string(name);
 
@@ -134,13 +134,13 @@ StringRef StringDatabase::string(String const& name) {
     return str;
 }
 
-StringRef StringDatabase::insert_string(String const& name) {
+StringRef StringDatabase::insert_string(StringView name) {
     COZ_BEGIN("T::StringDatabase::insert");
     std::size_t id      = size;
     auto&       strings = current_block();
     std::size_t n       = strings.size();
 
-    strings.push_back({name, 1, 0, 1});
+    strings.push_back({String(name), 1, 0, 1});
     StringView str = strings[n].data;
 
     defined[str] = {id};
@@ -151,7 +151,7 @@ StringRef StringDatabase::insert_string(String const& name) {
     return StringRef(id);
 }
 
-StringRef StringDatabase::lookup_or_insert_string(String const& name) {
+StringRef StringDatabase::lookup_or_insert_string(StringView name) {
 
     StopWatch<>                           timer;
     std::lock_guard<std::recursive_mutex> guard(mu);
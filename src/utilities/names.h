@@ -1,6 +1,7 @@
 ﻿#ifndef LYTHON_SRC_AST_HEADER
 #define LYTHON_SRC_AST_HEADER
 
+#include <atomic>
 #include <iostream>
 #include <memory>
 #include <mutex>
@@ -39,7 +40,7 @@ class StringDatabase {
 
     StringView operator[](std::size_t i) const;
 
-    StringRef string(String const& name);
+    StringRef string(StringView name);
 
     StringDatabase();
 
@@ -59,8 +60,8 @@ class StringDatabase {
     };
 
     private:
-    StringRef lookup_or_insert_string(String const& name);
-    StringRef insert_string(String const& name);
+    StringRef lookup_or_insert_string(StringView name);
+    StringRef insert_string(StringView name);
 
     std::size_t inc(std::size_t i);
 
@@ -94,8 +95,10 @@ class StringDatabase {
     Dict<StringView, std::size_t> defined;
 
     // Allocates strings in block to avoid reallocation
-    int         block_size = 1024;
-    std::size_t size       = 0;
+    int block_size = 1024;
+
+    // read without the lock by the references checking they are valid
+    std::atomic<std::size_t> size{0};
 
     List<Array<StringEntry>>   memory_blocks;
     Array<Array<StringEntry>*> reverse;
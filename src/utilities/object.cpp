@@ -4,6 +4,11 @@
 namespace lython {
 
 void GCObject::remove_child(GCObject* child, bool dofree) {
+    // arena objects are not tracked by their parent, only the arena can free them
+    if (child->_in_arena) {
+        child->parent = nullptr;
+        return;
+    }
 
     GCObject* result = nullptr;
     int       i      = int(children.size()) - 1;
@@ -115,6 +120,10 @@ void GCObject::free(GCObject* child) {
         assert(child->parent == nullptr, "parent should be null");
     }
 
+    if (child->_in_arena) {
+        return;
+    }
+
     private_free(child);
 }
 
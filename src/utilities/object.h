@@ -5,15 +5,33 @@
 
 #include "dependencies/coz_wrap.h"
 #include "dtypes.h"
+#include "utilities/arena.h"
 
 namespace lython {
 
+// Objects own the children they allocate and free them when they are destroyed.
+//
+// When an arena is set, children are allocated from the arena instead
+// and inherit it; the arena owns them and they are released all at once with it.
+// Nothing allocated from the arena can outlive it
 struct GCObject {
     public:
     template <typename T, typename... Args>
     T* new_object(Args&&... args) {
         COZ_BEGIN("T::GCObject::new_object");
 
+        if (_arena != nullptr) {
+            T* obj         = _arena->make<T>(std::forward<Args>(args)...);
+            obj->class_id  = meta::type_id<T>();
+            obj->_arena    = _arena;
+            obj->_in_arena = true;
+            obj->parent    = this;
+
+            COZ_PROGRESS_NAMED("GCObject::new_object");
+            COZ_END("T::GCObject::new_object");
+            return obj;
+        }
+
         auto& alloc = get_allocator<T>();
 
         // allocate
@@ -30,6 +48,7 @@ struct GCObject {
         return obj;
     }
 
+    //! Shallow copy, the copy points to the same children as obj
     template <typename T>
     typename std::remove_const<T>::type* copy(T* obj) {
         COZ_BEGIN("T::GCObject::copy");
@@ -42,8 +61,10 @@ struct GCObject {
         // construct
         NoConstT* nobj = new ((void*)memory) NoConstT(*obj);
 
-        nobj->class_id = meta::type_id<NoConstT>();
-        nobj->parent   = this;
+        nobj->class_id  = meta::type_id<NoConstT>();
+        nobj->parent    = this;
+        nobj->_arena    = nullptr;
+        nobj->_in_arena = false;
 
         COZ_PROGRESS_NAMED("GCObject::copy");
         COZ_END("T::GCObject::copy");
@@ -51,9 +72,12 @@ struct GCObject {
     }
 
     //! Make an object match the lifetime of the parent
+    //! arena objects already match the lifetime of their arena
     template <typename T>
     void add_child(T* child) {
-        children.push_back(child);
+        if (!child->_in_arena) {
+            children.push_back(child);
+        }
         child->parent = this;
     }
 
@@ -76,6 +100,11 @@ struct GCObject {
 
     static void free(GCObject* child);
 
+    //! Allocate the children of this object from the arena
+    void set_arena(Arena* arena) { _arena = arena; }
+
+    bool in_arena() const { return _in_arena; }
+
     void dump(std::ostream& out);
 
     virtual ~GCObject();
@@ -97,7 +126,9 @@ struct GCObject {
     GCObject* get_gc_parent() const { return parent; }
 
     private:
-    GCObject* parent = nullptr;
+    GCObject* parent    = nullptr;
+    Arena*    _arena    = nullptr;
+    bool      _in_arena = false;
 
     static void private_free(GCObject* child);
 };
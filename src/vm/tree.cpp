@@ -4,6 +4,7 @@
 #include "ast/values/generator.h"
 #include "ast/values/object.h"
 #include "logging/logging.h"
+#include "parser/parser.h"
 #include "parser/parsing_error.h"
 #include "utilities/guard.h"
 
@@ -360,6 +361,16 @@ PartialResult* TreeEvaluator::call_script(Call_t* call, FunctionDef_t* function,
         bindings.add(StringRef(), arg, nullptr);
     }
 
+    // a body with syntax errors cannot run
+    Array<ParsingError> syntax;
+    if (!materialize(function, &syntax)) {
+        for (ParsingError const& err: syntax) {
+            error("{}: {}", err.error_kind, err.message);
+        }
+        raise_exception(nullptr, nullptr);
+        return None();
+    }
+
     for (StmtNode* stmt: function->body) {
         exec(stmt, depth + 1);
 
@@ -1155,11 +1166,11 @@ void printtrace(StackTrace& trace) {
     String expr   = "";
 
     if (trace.stmt) {
-        line   = trace.stmt->lineno;
+        line   = trace.stmt->lineno();
         parent = shortprint(get_parent(trace.stmt));
         expr   = shortprint(trace.stmt);
     } else if (trace.expr) {
-        line   = trace.expr->lineno;
+        line   = trace.expr->lineno();
         parent = shortprint(trace.stmt);
         expr   = shortprint(trace.stmt);
     }
@@ -2,10 +2,21 @@
 #include "samples.h"
 
 #include "lexer/lexer.h"
+#include "lexer/parallel.h"
+#include "lexer/relex.h"
+#include "lexer/scan.h"
+#include "lexer/token_cache.h"
+#include "utilities/pool.h"
 #include "utilities/strings.h"
 
 #include <catch2/catch.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <sstream>
+#include <thread>
+
 using namespace lython;
 
 String lex_it(String code) {
@@ -56,4 +67,434 @@ NODEKIND_ENUM(X, SSECTION, EXPR, STMT, MOD, MATCH)
 #undef MATCH
 
 #undef GENTEST
-*/
\ No newline at end of file
+*/
+TEST_CASE("Buffer_getline") {
+    StringBuffer reader("def fun():\n    return 1\n\nx = 2");
+
+    REQUIRE(reader.getline(1) == "def fun():");
+    REQUIRE(reader.getline(2) == "    return 1");
+    REQUIRE(reader.getline(3) == "");
+    REQUIRE(reader.getline(4) == "x = 2");
+    REQUIRE(reader.getline(1, 2) == "def fun():\n    return 1");
+    REQUIRE(reader.getline(5) == "");
+}
+
+TEST_CASE("MappedFileBuffer") {
+    String code = simple_function();
+    String path = "mapped_buffer_test.ly";
+    {
+        FILE* file = fopen(path.c_str(), "w");
+        fwrite(code.data(), 1, code.size(), file);
+        fclose(file);
+    }
+
+    MappedFileBuffer mapped(path);
+    REQUIRE(mapped.source() == StringView(code.data(), code.size()));
+    REQUIRE(mapped.getline(1) == StringBuffer(code).getline(1));
+
+    Lexer        lex(mapped);
+    StringStream ss;
+    lex.print(ss);
+    REQUIRE(strip(ss.str()) == strip(lex_it(code)));
+
+    std::remove(path.c_str());
+}
+
+// Streamed buffers seek to the lines recorded while reading the blocks
+TEST_CASE("FileBuffer_getline") {
+    String code = all_code_samples();
+
+    // larger than a FileBuffer block
+    for (int i = 0; i < 4; i++) {
+        code += code;
+    }
+
+    String path = "file_getline_test.ly";
+    {
+        FILE* file = fopen(path.c_str(), "wb");
+        fwrite(code.data(), 1, code.size(), file);
+        fclose(file);
+    }
+
+    StringBuffer expected(code);
+    FileBuffer   reader(path);
+
+    int count = 1 + int(std::count(code.begin(), code.end(), '\n'));
+    auto check = [&]() {
+        for (int line: {1, 2, count / 2, count - 1, count, count + 1}) {
+            INFO(line);
+            REQUIRE(reader.getline(line) == expected.getline(line));
+        }
+        REQUIRE(reader.getline(count / 2, count / 2 + 3) ==
+                expected.getline(count / 2, count / 2 + 3));
+    };
+
+    // only the first block was read
+    check();
+
+    Lexer lex(reader);
+    lex.extract_token();
+    check();
+
+    reader.reset();
+    check();
+
+    std::remove(path.c_str());
+}
+
+// Streamed buffers copy the token text inside the lexer
+// in-memory buffers point to their source, both should produce the same tokens
+TEST_CASE("Token_text") {
+    String path = "token_text_test.ly";
+
+    auto check = [&](String const& code) {
+        FILE* file = fopen(path.c_str(), "w");
+        fwrite(code.data(), 1, code.size(), file);
+        fclose(file);
+
+        StringBuffer string_reader(code);
+        FileBuffer   file_reader(path);
+        Lexer        string_lex(string_reader);
+        Lexer        file_lex(file_reader);
+
+        require_same_tokens(file_lex.extract_token(), string_lex.extract_token());
+    };
+
+#define CHECK_SAMPLE(name) \
+    {                      \
+        INFO(#name);       \
+        check(name());     \
+    }
+
+    CODE_SAMPLES(CHECK_SAMPLE)
+
+#undef CHECK_SAMPLE
+
+    std::remove(path.c_str());
+
+    StringBuffer reader("a = \"str\"\nb = \"\"\n\"\"\"doc\"\"\"\n");
+    Lexer        lex(reader);
+
+    REQUIRE(lex.next_token().identifier() == "a");
+    REQUIRE(lex.next_token().identifier() == "=");
+    REQUIRE(lex.next_token().identifier() == "str");
+    REQUIRE(lex.next_token().type() == tok_newline);
+    REQUIRE(lex.next_token().identifier() == "b");
+    REQUIRE(lex.next_token().identifier() == "=");
+
+    Token empty = lex.next_token();
+    REQUIRE(empty.type() == tok_string);
+    REQUIRE(empty.identifier() == "");
+
+    REQUIRE(lex.next_token().type() == tok_newline);
+
+    Token doc = lex.next_token();
+    REQUIRE(doc.type() == tok_docstring);
+    REQUIRE(doc.identifier() == "doc");
+}
+
+// every entry of the X-macro tables is recognized by the generated tables
+TEST_CASE("Reserved_words") {
+    auto first_token = [](StringView str) {
+        StringBuffer reader(String(str) + " x");
+        Lexer        lex(reader);
+        return lex.next_token();
+    };
+
+    // string operators (is, not, ...) are keywords lexed as operators
+#define X(str, tok)                                                        \
+    {                                                                      \
+        INFO(str);                                                         \
+        Token token = first_token(str);                                    \
+        if (default_precedence().count(str) > 0) {                         \
+            REQUIRE(token.operator_name() == str);                         \
+        } else {                                                           \
+            REQUIRE(token.type() == tok);                                  \
+        }                                                                  \
+    }
+    LYTHON_KEYWORDS(X)
+#undef X
+
+    // combined operators (is not, not in) keep the type of their first word
+#define X(str, ...)                                                        \
+    {                                                                      \
+        INFO(str);                                                         \
+        Token token = first_token(str);                                    \
+        REQUIRE(token.operator_name() == str);                             \
+        REQUIRE(token.operator_id() == operator_id(str));                  \
+        REQUIRE(operator_table[token.operator_id()].name == str);          \
+        if (StringView(str).find(' ') == StringView::npos) {               \
+            REQUIRE(token.type() == OpConfig{__VA_ARGS__}.type);           \
+        }                                                                  \
+    }
+    LYTHON_OPERATORS(X)
+#undef X
+
+    StringBuffer reader("definitely classy");
+    Lexer        lex(reader);
+    REQUIRE(lex.next_token().type() == tok_identifier);
+    REQUIRE(lex.next_token().type() == tok_identifier);
+    REQUIRE(lex.token().operator_id() == 0);
+}
+
+TEST_CASE("Lexer_peek") {
+    StringBuffer reader("a is not b not in c is d\n");
+    Lexer        lex(reader);
+
+    REQUIRE(lex.token().identifier() == "a");
+    REQUIRE(lex.peek(1).operator_name() == "is not");
+    REQUIRE(lex.peek(3).operator_name() == "not in");
+    REQUIRE(lex.peek(4).identifier() == "c");
+    REQUIRE(lex.peek(2).identifier() == "b");
+    REQUIRE(lex.peek_token().operator_name() == "is not");
+
+    // peeking does not move the lexer
+    REQUIRE(lex.token().identifier() == "a");
+
+    Array<String> expected = {"is not", "b", "not in", "c", "is", "d"};
+    for (String const& str: expected) {
+        REQUIRE(lex.next_token().identifier() == str);
+    }
+    REQUIRE(lex.next_token().type() == tok_newline);
+    REQUIRE(lex.peek(3).type() == tok_eof);
+}
+
+TEST_CASE("Parallel_lex") {
+    String code;
+    for (int i = 0; i < 20; i++) {
+        code += all_code_samples();
+    }
+
+    StringBuffer serial_reader(code);
+    Lexer        serial(serial_reader);
+    Array<Token> expected = serial.extract_token();
+
+    REQUIRE(find_split_points(code, 256).size() > 10);
+
+    ThreadPool   pool(4);
+    StringBuffer reader(code);
+    require_same_tokens(parallel_lex(reader, pool, 256), expected);
+
+    // splits ignore strings, comments and brackets
+    String tricky = "a = (\nb)\nc = \"\"\"\nd\"\"\"\ne = \"\nf\"\n# (\ng\n";
+    Array<SplitPoint> points = find_split_points(tricky, 0);
+
+    REQUIRE(points.size() == 3);
+    REQUIRE(tricky[points[0].offset] == 'c');
+    REQUIRE(points[0].line == 3);
+    REQUIRE(tricky[points[1].offset] == 'e');
+    REQUIRE(points[1].line == 5);
+    REQUIRE(tricky[points[2].offset] == 'g');
+    REQUIRE(points[2].line == 8);
+}
+
+TEST_CASE("TokenCache") {
+    String code = all_code_samples();
+
+    StringBuffer serial_reader(code);
+    Lexer        serial(serial_reader);
+    Array<Token> expected = serial.extract_token();
+
+    String cache_dir = "token_cache_test";
+    std::filesystem::remove_all(cache_dir.c_str());
+
+    StringBuffer miss_reader(code);
+    TokenCache   miss(miss_reader, cache_dir);
+    REQUIRE(!miss.hit());
+
+    StringBuffer hit_reader(code);
+    TokenCache   hit(hit_reader, cache_dir);
+    REQUIRE(hit.hit());
+
+    require_same_tokens(hit.tokens(), expected);
+
+    // the replayed tokens format like the ones read from the source, first one included
+    StringBuffer      print_reader(code);
+    Lexer             print_lex(print_reader);
+    std::stringstream lexed;
+    print_lex.print(lexed);
+
+    ReplayLexer       replay(hit.tokens());
+    std::stringstream replayed;
+    replay.print(replayed);
+
+    REQUIRE(replayed.str() == lexed.str());
+
+    // a different source is a different entry
+    StringBuffer changed_reader(code + "a = 1\n");
+    TokenCache   changed(changed_reader, cache_dir);
+    REQUIRE(!changed.hit());
+
+    // stale or corrupted entries are ignored
+    uint64 hash = source_hash(code);
+    String path = token_cache_path(cache_dir, hash);
+    REQUIRE(save_token_cache(path, hash + 1, code.size(), expected));
+
+    StringBuffer stale_reader(code);
+    TokenCache   stale(stale_reader, cache_dir);
+    REQUIRE(!stale.hit());
+    REQUIRE(stale.tokens().size() == expected.size());
+
+    // concurrent writers of the same entry do not clobber each other
+    Array<std::thread> writers;
+    std::atomic<int>   saved = 0;
+    for (int i = 0; i < 4; i++) {
+        writers.emplace_back([&]() { saved += int(save_token_cache(path, hash, code.size(), expected)); });
+    }
+    for (std::thread& writer: writers) {
+        writer.join();
+    }
+    REQUIRE(saved == 4);
+
+    StringBuffer concurrent_reader(code);
+    TokenCache   concurrent(concurrent_reader, cache_dir);
+    REQUIRE(concurrent.hit());
+    require_same_tokens(concurrent.tokens(), expected);
+
+    int entries = 0;
+    for (auto const& entry: std::filesystem::directory_iterator(cache_dir.c_str())) {
+        entries += int(entry.is_regular_file());
+    }
+    REQUIRE(entries == 2);
+
+    std::filesystem::remove_all(cache_dir.c_str());
+}
+
+TEST_CASE("Buffer_hash") {
+    String code = all_code_samples();
+
+    // larger than a FileBuffer block
+    for (int i = 0; i < 4; i++) {
+        code += code;
+    }
+
+    String file_name = "buffer_hash_test.ly";
+    {
+        FILE* file = fopen(file_name.c_str(), "wb");
+        fwrite(code.data(), 1, code.size(), file);
+        fclose(file);
+    }
+
+    uint64 expected = source_hash(code);
+
+    StringBuffer string_reader(code);
+    REQUIRE(string_reader.hash() == expected);
+
+    MappedFileBuffer mapped_reader(file_name);
+    REQUIRE(mapped_reader.hash() == expected);
+
+    // streamed buffers hash the blocks as they are read
+    FileBuffer file_reader(file_name);
+    Lexer      lex(file_reader);
+    lex.extract_token();
+    REQUIRE(file_reader.hash() == expected);
+
+    file_reader.reset();
+    Lexer relex(file_reader);
+    relex.extract_token();
+    REQUIRE(file_reader.hash() == expected);
+
+    StringBuffer other_reader(code + " ");
+    REQUIRE(other_reader.hash() != expected);
+
+    std::remove(file_name.c_str());
+}
+
+TEST_CASE("Relex") {
+    String code = all_code_samples();
+
+    StringBuffer old_reader(code);
+    Lexer        old_lex(old_reader);
+    Array<Token> old_tokens = old_lex.extract_token();
+
+    Array<String> insertions = {
+        "",
+        "a",
+        "\n",
+        "    ",
+        "\"",
+        "\"\"\"",
+        "#",
+        "(",
+        "def f():\n    pass\n",
+        "\nclass A:\n    x = 1\n\n",
+    };
+
+    std::size_t step    = std::max<std::size_t>(code.size() / 97, 1);
+    std::size_t partial = 0;
+    std::size_t count   = 0;
+
+    for (std::size_t offset = 0; offset < code.size(); offset += step) {
+        for (std::size_t removed: {0, 1, 7}) {
+            for (String const& text: insertions) {
+                removed = std::min(removed, code.size() - offset);
+
+                String new_code = code.substr(0, offset) + text + code.substr(offset + removed);
+
+                StringBuffer reader(new_code);
+                Lexer        lex(reader);
+                Array<Token> expected = lex.extract_token();
+
+                SourceEdit edit;
+                edit.offset  = offset;
+                edit.removed = removed;
+                edit.text    = text;
+
+                Array<Token> tokens = old_tokens;
+                TokenRange   range  = relex(tokens, code, new_code, edit);
+
+                INFO("offset: " << offset << " removed: " << removed << " text: `" << text << "`");
+                REQUIRE(range.new_end - range.begin <= expected.size());
+                REQUIRE(tokens.size() == expected.size());
+                REQUIRE(tokens.size() - range.new_end == old_tokens.size() - range.old_end);
+                require_same_tokens(tokens, expected);
+
+                partial += range.new_end - range.begin < expected.size() / 2;
+                count += 1;
+            }
+        }
+    }
+
+    // most edits only relex a small part of the file
+    REQUIRE(partial * 2 > count);
+}
+
+TEST_CASE("Scanners") {
+    Array<Scanners const*> impls = {sse2_scanners(), avx2_scanners()};
+    Scanners const&        ref   = scalar_scanners();
+
+    // runs of every length, stopped by each kind of character
+    String stops = " \n\"#(.\x80";
+    String fill  = "abcXYZ_09?!-";
+
+    for (Scanners const* impl: impls) {
+        if (impl == nullptr) {
+            continue;
+        }
+        INFO(impl->name);
+
+        for (int size = 0; size < 80; size++) {
+            for (char stop: stops) {
+                String run(std::size_t(size), fill[std::size_t(size) % fill.size()]);
+                run.push_back(stop);
+                run += "tail";
+
+                const char* begin = run.data();
+                const char* end   = run.data() + run.size();
+
+                REQUIRE(impl->identifier(begin, end) == ref.identifier(begin, end));
+                REQUIRE(impl->line(begin, end) == ref.line(begin, end));
+                REQUIRE(impl->string(begin, end) == ref.string(begin, end));
+
+                String spaces(std::size_t(size), ' ');
+                spaces.push_back(stop);
+                begin = spaces.data();
+                end   = spaces.data() + spaces.size();
+                REQUIRE(impl->spaces(begin, end) == ref.spaces(begin, end));
+
+                // must not read past end
+                REQUIRE(impl->spaces(begin, begin + size) == begin + size);
+            }
+        }
+    }
+}
@@ -2,12 +2,17 @@
 #include "samples.h"
 
 #include <catch2/catch.hpp>
+#include <filesystem>
 #include <sstream>
 
+#include "ast/ops.h"
 #include "lexer/buffer.h"
 #include "lexer/lexer.h"
+#include "lexer/relex.h"
 #include "logging/logging.h"
 #include "parser/parser.h"
+#include "parser/precompiled.h"
+#include "utilities/pool.h"
 #include "utilities/strings.cpp"
 
 using namespace lython;
@@ -41,6 +46,398 @@ TEST_CASE("Parser") {
 
 TEST_CASE("Parser_Ext_IfExp") { REQUIRE(parse_it("d = if a: b else c") == "d = b if a else c"); }
 
+TEST_CASE("Parser_Arena") {
+    StringBuffer reader(simple_function());
+    Lexer        lex(reader);
+    Parser       parser(lex);
+
+    auto mod = Unique<Module>(parser.parse_module());
+
+    REQUIRE(mod->arena != nullptr);
+    REQUIRE(mod->arena->allocated() > 0);
+    REQUIRE(!mod->in_arena());
+    REQUIRE(mod->body.size() == 1);
+    REQUIRE(mod->body[0]->in_arena());
+
+    // children of arena nodes come from the arena too
+    auto fun = static_cast<FunctionDef*>(mod->body[0]);
+    REQUIRE(fun->body.size() == 1);
+    REQUIRE(fun->body[0]->in_arena());
+
+    // nodes that outlive the module are copied out
+    GCObject root;
+    auto     copy = root.copy(static_cast<Return*>(fun->body[0]));
+    root.add_child(copy);
+    REQUIRE(!copy->in_arena());
+
+    // heap nodes added to the module are owned by their parent as usual
+    auto heap = root.new_object<Pass>();
+    heap->move(fun);
+    REQUIRE(!heap->in_arena());
+
+    mod.reset();
+    REQUIRE(copy->kind == NodeKind::Return);
+}
+
+TEST_CASE("Parser_Lazy_Bodies") {
+    String code = "def f(a: i32) -> i32:\n"
+                  "    \"\"\"doc\"\"\"\n"
+                  "    def g(b):\n"
+                  "        return b + 1\n"
+                  "    return g(a) * 2\n"
+                  "\n"
+                  "class A:\n"
+                  "    def m(self, x):\n"
+                  "        if x:\n"
+                  "            return x\n"
+                  "        return self\n"
+                  "\n"
+                  "x = f(1)\n";
+
+    StringBuffer reader(code);
+    Lexer        lex(reader);
+    Parser       parser(lex);
+    parser.set_lazy_bodies(true);
+
+    auto mod = Unique<Module>(parser.parse_module());
+    REQUIRE(mod->body.size() == 3);
+
+    auto f = static_cast<FunctionDef*>(mod->body[0]);
+    auto m = static_cast<FunctionDef*>(static_cast<ClassDef*>(mod->body[1])->body[0]);
+
+    REQUIRE(f->lazy.pending());
+    REQUIRE(f->body.empty());
+    REQUIRE(m->lazy.pending());
+
+    REQUIRE(materialize(f));
+    REQUIRE(materialize(m));
+    REQUIRE(!f->lazy.pending());
+    REQUIRE(f->body.size() == 2);
+
+    // nested definitions are parsed eagerly once the outer body is
+    REQUIRE(!static_cast<FunctionDef*>(f->body[0])->lazy.pending());
+
+    REQUIRE(strip(str(mod.get())) == strip(parse_it(code)));
+
+    // syntax errors are found when the body is parsed
+    String       invalid = "def f(a):\n    x = )\n    return a\n";
+    StringBuffer invalid_reader(invalid);
+    Lexer        invalid_lex(invalid_reader);
+    Parser       invalid_parser(invalid_lex);
+    invalid_parser.set_lazy_bodies(true);
+
+    auto invalid_mod = Unique<Module>(invalid_parser.parse_module());
+    REQUIRE(invalid_parser.get_errors().empty());
+
+    Array<ParsingError> errors;
+    REQUIRE(!materialize(static_cast<FunctionDef*>(invalid_mod->body[0]), &errors));
+    REQUIRE(errors.size() == 1);
+    REQUIRE(errors[0].received_token.line() == 2);
+}
+
+inline Module* parse_parallel(String const& code, Array<ParsingError>& errors) {
+    ThreadPool   pool(4);
+    StringBuffer reader(code);
+    Lexer        lex(reader);
+    Parser       parser(lex);
+
+    Module* mod = parser.parse_module(pool, 256);
+    errors      = parser.get_errors();
+    return mod;
+}
+
+TEST_CASE("Parser_Parallel") {
+    String samples = all_code_samples();
+    String code;
+    for (int i = 0; i < 10; i++) {
+        code += samples;
+    }
+
+    StringBuffer serial_reader(code);
+    Lexer        serial_lex(serial_reader);
+    Parser       serial(serial_lex);
+    auto         expected = Unique<Module>(serial.parse_module());
+
+    Array<ParsingError> errors;
+    auto                mod = Unique<Module>(parse_parallel(code, errors));
+
+    REQUIRE(mod->arenas.size() > 10);
+    REQUIRE(equal(mod.get(), expected.get()));
+    REQUIRE(errors.empty());
+
+    // errors are merged in order, invalid statements never compare equal
+    String invalid;
+    for (int i = 0; i < 10; i++) {
+        invalid += samples;
+        invalid += "x = )\n";
+    }
+
+    StringBuffer invalid_reader(invalid);
+    Lexer        invalid_lex(invalid_reader);
+    Parser       invalid_serial(invalid_lex);
+    expected = Unique<Module>(invalid_serial.parse_module());
+
+    mod = Unique<Module>(parse_parallel(invalid, errors));
+    REQUIRE(str(mod.get()) == str(expected.get()));
+
+    auto const& expected_errors = invalid_serial.get_errors();
+    REQUIRE(errors.size() == expected_errors.size());
+    for (std::size_t i = 0; i < errors.size(); i++) {
+        REQUIRE(errors[i].message == expected_errors[i].message);
+        REQUIRE(errors[i].received_token.line() == expected_errors[i].received_token.line());
+    }
+}
+
+// Lines of the statements, definitions included
+inline void statement_lines(Array<StmtNode*> const& body, Array<int>& lines) {
+    for (StmtNode* stmt: body) {
+        lines.push_back(stmt->lineno());
+        lines.push_back(stmt->end_lineno().has_value() ? stmt->end_lineno().value() : 0);
+
+        if (stmt->kind == NodeKind::FunctionDef) {
+            statement_lines(static_cast<FunctionDef*>(stmt)->body, lines);
+        } else if (stmt->kind == NodeKind::ClassDef) {
+            statement_lines(static_cast<ClassDef*>(stmt)->body, lines);
+        }
+    }
+}
+
+TEST_CASE("Parser_Reparse") {
+    String code = "def f(a):\n"
+                  "    b = a + 1\n"
+                  "    c = b * 2\n"
+                  "    return c\n"
+                  "\n"
+                  "class A:\n"
+                  "    def m(self, x):\n"
+                  "        y = x\n"
+                  "        return y\n"
+                  "\n"
+                  "    def n(self):\n"
+                  "        return 1\n"
+                  "\n"
+                  "x = f(1)\n"
+                  "y = A()\n";
+
+    StringBuffer reader(code);
+    Lexer        lex(reader);
+    Array<Token> tokens = lex.extract_token();
+    ReplayLexer  replay(tokens);
+    Parser       parser(replay);
+    auto         mod = Unique<Module>(parser.parse_module());
+
+    // sources the tokens point to
+    List<String> sources = {code};
+
+    auto apply = [&](String const& before, String const& after) {
+        String const& old_code = sources.back();
+        std::size_t   offset   = old_code.find(before);
+        REQUIRE(offset != String::npos);
+
+        String new_code = old_code.substr(0, offset) + after + old_code.substr(offset + before.size());
+
+        SourceEdit edit;
+        edit.offset  = offset;
+        edit.removed = before.size();
+        edit.text    = after;
+
+        sources.push_back(new_code);
+        TokenRange range = relex(tokens, old_code, sources.back(), edit);
+        parser.reparse(mod.get(), tokens, range);
+
+        StringBuffer full_reader(new_code);
+        Lexer        full_lex(full_reader);
+        Parser       full(full_lex);
+        auto         expected = Unique<Module>(full.parse_module());
+
+        Array<int> lines;
+        Array<int> expected_lines;
+        statement_lines(mod->body, lines);
+        statement_lines(expected->body, expected_lines);
+
+        INFO(new_code);
+        REQUIRE(str(mod.get()) == str(expected.get()));
+        REQUIRE(equal(mod.get(), expected.get()));
+        REQUIRE(lines == expected_lines);
+
+        auto const& errors          = parser.get_errors();
+        auto const& expected_errors = full.get_errors();
+        REQUIRE(errors.size() == expected_errors.size());
+        for (std::size_t i = 0; i < errors.size(); i++) {
+            REQUIRE(errors[i].message == expected_errors[i].message);
+            REQUIRE(errors[i].received_token.line() == expected_errors[i].received_token.line());
+        }
+    };
+
+    auto f = static_cast<FunctionDef*>(mod->body[0]);
+    auto A = static_cast<ClassDef*>(mod->body[1]);
+    auto m = static_cast<FunctionDef*>(A->body[0]);
+    auto x = mod->body[2];
+
+    // only the statement holding the edit is parsed again
+    StmtNode* c = f->body[1];
+    apply("a + 1", "a + 10");
+    REQUIRE(mod->body[0] == f);
+    REQUIRE(f->body[1] == c);
+    REQUIRE(mod->arenas.size() == 1);
+
+    // the nodes after the edit move down
+    apply("        y = x\n", "        y = x\n        z = y\n");
+    REQUIRE(A->body[0] == m);
+    REQUIRE(m->body.size() == 3);
+    REQUIRE(mod->body[2] == x);
+    REQUIRE(x->lineno() == 15);
+
+    // definitions whose header changed are parsed again as a whole
+    apply("def n(self)", "def k(self)");
+    REQUIRE(A->body[0] == m);
+    REQUIRE(mod->body[2] == x);
+
+    // the errors of the statements parsed again are replaced, the others move with them
+    apply("        z = y\n", "        z = )\n");
+    REQUIRE(parser.get_errors().size() == 1);
+    apply("    return c\n", "    return c\n\n");
+    REQUIRE(parser.get_errors()[0].received_token.line() == 10);
+    apply("        z = )\n", "        z = y\n");
+    REQUIRE(!parser.has_errors());
+    apply("    return c\n\n", "    return c\n");
+
+    // lines are removed
+    apply("    c = b * 2\n", "");
+    REQUIRE(mod->body[0] == f);
+    REQUIRE(x->lineno() == 14);
+
+    // statements moving to another block
+    apply("\nx = f(1)", "\n        x = f(1)");
+    apply("    return c\n", "return c\n");
+    apply("y = A()\n", "");
+}
+
+// The line of an error is read back from the tokens of a replay lexer
+// and lexed again from the source by a streaming lexer
+TEST_CASE("Parser_Error_Line") {
+    String code = "a = 1\nb = (2 +\nc = 3\ndef f(x):\n    return x +\n";
+
+    StringBuffer reader(code);
+    Lexer        lex(reader);
+    Parser       streamed(lex);
+    auto         mod = Unique<Module>(streamed.parse_module());
+
+    StringBuffer reader2(code);
+    Lexer        lex2(reader2);
+    Array<Token> tokens = lex2.extract_token();
+    ReplayLexer  replay(tokens);
+    Parser       replayed(replay);
+    auto         expected = Unique<Module>(replayed.parse_module());
+
+    Array<ParsingError> const& errors = streamed.get_errors();
+    REQUIRE(errors.size() > 0);
+    REQUIRE(errors.size() == replayed.get_errors().size());
+
+    for (std::size_t i = 0; i < errors.size(); i++) {
+        Array<Token> const& line = replayed.get_errors()[i].line();
+        REQUIRE(errors[i].line().size() == line.size());
+
+        for (std::size_t k = 0; k < line.size(); k++) {
+            CHECK(errors[i].line()[k] == line[k]);
+            CHECK(errors[i].line()[k].identifier() == line[k].identifier());
+        }
+
+        Array<Token> remaining = replayed.get_errors()[i].remaining();
+        REQUIRE(errors[i].remaining().size() == remaining.size());
+
+        for (std::size_t k = 0; k < remaining.size(); k++) {
+            CHECK(errors[i].remaining()[k] == remaining[k]);
+        }
+    }
+}
+
+TEST_CASE("Parser_Source_Span") {
+    REQUIRE(sizeof(CommonAttributes) == 8);
+
+    CommonAttributes loc;
+    REQUIRE(loc.lineno() == -2);
+    REQUIRE(!loc.end_lineno().has_value());
+
+    loc.set_start(0, 0);
+    loc.set_end(3);
+    REQUIRE(loc.lineno() == 0);
+    REQUIRE(loc.col_offset() == 0);
+    REQUIRE(loc.end_lineno().value() == 3);
+    REQUIRE(!loc.end_col_offset().has_value());
+
+    loc.set_start(CommonAttributes::max_line, 1 << 20);
+    loc.set_end(CommonAttributes::max_line + 1, 4);
+    REQUIRE(loc.lineno() == CommonAttributes::max_line);
+    REQUIRE(loc.col_offset() == CommonAttributes::max_column);
+    REQUIRE(!loc.end_lineno().has_value());
+
+    StringBuffer reader("a = 1\ndef f(x):\n    return x\n");
+    Lexer        lex(reader);
+    Parser       parser(lex);
+    auto         mod = Unique<Module>(parser.parse_module());
+
+    REQUIRE(mod->body[1]->lineno() == 2);
+    REQUIRE(mod->body[1]->col_offset() == 0);
+    REQUIRE(mod->body[1]->end_lineno().has_value());
+}
+
+TEST_CASE("Parser_Precompiled") {
+    String code = all_code_samples();
+
+    StringBuffer reader(code);
+    Lexer        lex(reader);
+    Parser       parser(lex);
+    parser.set_lazy_bodies(true);
+    auto expected = Unique<Module>(parser.parse_module());
+
+    // lazy bodies are parsed before being saved
+    String data = dump_module(expected.get(), reader.hash(), code.size());
+    auto   mod  = Unique<Module>(load_module(data));
+
+    REQUIRE(mod != nullptr);
+    REQUIRE(mod->in_arena() == false);
+    REQUIRE(mod->body[0]->in_arena());
+    REQUIRE(equal(mod.get(), expected.get()));
+    REQUIRE(str(mod.get()) == str(expected.get()));
+
+    // malformed data is rejected
+    REQUIRE(load_module(StringView(data).substr(0, data.size() - 1)) == nullptr);
+
+    // a string pointing outside of the text section
+    String corrupted = data;
+    corrupted[sizeof(ModuleFileHeader) + 3] = char(0x7f);
+    REQUIRE(load_module(corrupted) == nullptr);
+
+    // files are only loaded for the source they were saved for
+    String path = "precompiled_test.lyc";
+    REQUIRE(save_module(path, expected.get(), reader.hash(), code.size()));
+
+    mod = Unique<Module>(load_module_file(path, reader.hash(), code.size()));
+    REQUIRE(mod != nullptr);
+    REQUIRE(equal(mod.get(), expected.get()));
+
+    REQUIRE(load_module_file(path, reader.hash() + 1, code.size()) == nullptr);
+    REQUIRE(load_module_file("missing.lyc", reader.hash(), code.size()) == nullptr);
+    std::remove(path.c_str());
+
+    // bodies with syntax errors are not saved as if the module was clean
+    String       invalid = "def f(a):\n    x = )\n    return a\n";
+    StringBuffer invalid_reader(invalid);
+    Lexer        invalid_lex(invalid_reader);
+    Parser       invalid_parser(invalid_lex);
+    invalid_parser.set_lazy_bodies(true);
+    auto invalid_mod = Unique<Module>(invalid_parser.parse_module());
+
+    Array<ParsingError> errors;
+    REQUIRE(dump_module(invalid_mod.get(), invalid_reader.hash(), invalid.size(), &errors).empty());
+    REQUIRE(errors.size() == 1);
+
+    String invalid_path = "precompiled_invalid_test.lyc";
+    REQUIRE(!save_module(invalid_path, invalid_mod.get(), invalid_reader.hash(), invalid.size()));
+    REQUIRE(!std::filesystem::exists(invalid_path.c_str()));
+}
+
 struct AllowEntry {
     String name;
     int    j;
@@ -128,6 +525,36 @@ void show_debug(
     }
 }
 
+// Parsing without exceptions should produce the same diagnostics and the same tree
+void check_error_modes(Array<Token> const& tokens) {
+    Array<Token> throw_tokens(tokens);
+    Array<Token> return_tokens(tokens);
+    ReplayLexer  throw_lexer(throw_tokens);
+    ReplayLexer  return_lexer(return_tokens);
+
+    Parser throwing(throw_lexer);
+    Parser returning(return_lexer);
+    returning.set_throw_errors(false);
+
+    Module throw_mod;
+    Module return_mod;
+    throwing.parse_to_module(&throw_mod);
+    returning.parse_to_module(&return_mod);
+
+    Array<ParsingError> const& expected = throwing.get_errors();
+    Array<ParsingError> const& received = returning.get_errors();
+
+    REQUIRE(expected.size() == received.size());
+    for (std::size_t k = 0; k < expected.size(); k++) {
+        CHECK(expected[k].error_kind == received[k].error_kind);
+        CHECK(expected[k].message == received[k].message);
+        CHECK(expected[k].expected_tokens == received[k].expected_tokens);
+        CHECK(expected[k].received_token.type() == received[k].received_token.type());
+        CHECK(expected[k].received_token.line() == received[k].received_token.line());
+    }
+    CHECK(str(&throw_mod) == str(&return_mod));
+}
+
 // Runs code through the parser but remove some tokens
 void run_partial(String const& name, int j, TestCase const& test) {
     StringBuffer reader(test.code);
@@ -136,7 +563,9 @@ void run_partial(String const& name, int j, TestCase const& test) {
 
     for (int i = 1; i < toks.size() - 1; i++) {
         Array<Token> tokens(std::begin(toks), std::begin(toks) + i);
-        ReplayLexer  lexer(tokens);
+        check_error_modes(tokens);
+
+        ReplayLexer lexer(tokens);
 
         Parser parser(lexer);
         auto   expr = [&]() {
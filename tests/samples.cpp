@@ -141,3 +141,17 @@ DEFINE_SAMPLE_CODE(edge_case_incorrect_tok,
 DEFINE_SAMPLE_CODE(edge_case_incorrect_num,
                    "c = 1.1.1\n";  // tok_identifier '=' tok_incorrect
 )
+
+lython::String all_code_samples() {
+    lython::String code;
+
+#define APPEND(name) \
+    code += name();  \
+    code += "\n";
+
+    CODE_SAMPLES(APPEND)
+
+#undef APPEND
+
+    return code;
+}
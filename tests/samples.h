@@ -2,6 +2,9 @@
 #define LYTHON_TESTS_SAMPLES_HEADER
 
 #include "dtypes.h"
+#include "lexer/token.h"
+
+#include <catch2/catch.hpp>
 
 #define CODE_SAMPLES(X)            \
     X(simple_function)             \
@@ -36,4 +39,23 @@ IMPORT_TEST(SAMPLE_PROTO)
 
 #undef SAMPLE_PROTO
 
+// Every code sample, each one followed by an empty line
+lython::String all_code_samples();
+
+// Both streams hold the same tokens, with the same text and operators.
+// Inline so the benchmarks linking the samples do not need the Catch runner
+inline void require_same_tokens(lython::Array<lython::Token> const& tokens,
+                                lython::Array<lython::Token> const& expected) {
+    REQUIRE(tokens.size() == expected.size());
+
+    for (std::size_t i = 0; i < tokens.size(); i++) {
+        INFO(i);
+        REQUIRE(tokens[i].type() == expected[i].type());
+        REQUIRE(tokens[i].line() == expected[i].line());
+        REQUIRE(tokens[i].col() == expected[i].col());
+        REQUIRE(tokens[i].identifier() == expected[i].identifier());
+        REQUIRE(tokens[i].operator_id() == expected[i].operator_id());
+    }
+}
+
 #endif
@@ -1,12 +1,18 @@
 #include "ast/magic.h"
+#include "builtin/operators.h"
 #include "lexer/buffer.h"
 #include "parser/parser.h"
 #include "revision_data.h"
+#include "sema/modules.h"
 #include "sema/sema.h"
+#include "utilities/pool.h"
 #include "utilities/strings.h"
 
 #include <catch2/catch.hpp>
+#include <filesystem>
+#include <fstream>
 #include <sstream>
+#include <thread>
 
 #include "logging/logging.h"
 
@@ -85,6 +91,411 @@ TEST_CASE("SEMA_FunctionDef_Typing") {
 
 TEST_CASE("SEMA_Match_Details") {}
 
+TEST_CASE("SEMA_Bindings_Shadowing") {
+    Bindings bindings;
+    StringRef a("a");
+    StringRef b("b");
+
+    int global = bindings.add(a, nullptr, nullptr);
+    REQUIRE(bindings.get_varid(a) == global);
+    REQUIRE(bindings.get_varid(b) == -1);
+    REQUIRE(!bindings.is_dynamic(global));
+
+    {
+        Scope scope(bindings);
+        int   local = bindings.add(a, nullptr, nullptr);
+        int   other = bindings.add(b, nullptr, nullptr);
+
+        REQUIRE(bindings.get_varid(a) == local);
+        REQUIRE(bindings.get_varid(b) == other);
+        REQUIRE(bindings.is_dynamic(local));
+
+        {
+            Scope inner(bindings);
+            int   again = bindings.add(a, nullptr, nullptr);
+            REQUIRE(bindings.get_varid(a) == again);
+        }
+        REQUIRE(bindings.get_varid(a) == local);
+    }
+
+    REQUIRE(bindings.get_varid(a) == global);
+    REQUIRE(bindings.get_varid(b) == -1);
+    REQUIRE(bindings.get_varid(StringRef("None")) >= 0);
+}
+
+TEST_CASE("SEMA_Native_Operators") {
+    using Id = BuiltinTypeId;
+
+    auto add = get_native_binary_operation(BinaryOperator::Add, Id::Ti32, Id::Ti32);
+    REQUIRE(add != nullptr);
+    REQUIRE(add(ConstantValue(int32(2)), ConstantValue(int32(3))).get<int32>() == 5);
+
+    // operands need to be of the same builtin type
+    REQUIRE(get_native_binary_operation(BinaryOperator::Add, Id::Ti32, Id::Tf64) == nullptr);
+    REQUIRE(get_native_binary_operation(BinaryOperator::Add, Id::Tstr, Id::Tstr) == nullptr);
+    REQUIRE(get_native_binary_operation(BinaryOperator::Add, Id::Count, Id::Ti32) == nullptr);
+    REQUIRE(get_native_binary_operation(BinaryOperator::BitAnd, Id::Tf32, Id::Tf32) == nullptr);
+    REQUIRE(get_native_binary_operation(BinaryOperator::BitAnd, Id::Tu8, Id::Tu8) != nullptr);
+
+    REQUIRE(get_native_cmp_operation(CmpOperator::Gt, Id::Tf64, Id::Tf64) != nullptr);
+    REQUIRE(get_native_cmp_operation(CmpOperator::In, Id::Ti32, Id::Ti32) == nullptr);
+
+    REQUIRE(get_native_bool_operation(BoolOperator::And, Id::Tbool, Id::Tbool) != nullptr);
+    REQUIRE(get_native_bool_operation(BoolOperator::And, Id::Ti32, Id::Ti32) == nullptr);
+
+    REQUIRE(get_native_unary_operation(UnaryOperator::USub, Id::Tf32) != nullptr);
+    REQUIRE(get_native_unary_operation(UnaryOperator::Invert, Id::Tf32) == nullptr);
+
+    // builtin types are found through their name
+    SemanticAnalyser sema;
+    Module           mod;
+    REQUIRE(builtin_type_id(sema.make_ref(&mod, "i32")) == Id::Ti32);
+    REQUIRE(builtin_type_id(bool_t()) == Id::Tbool);
+    REQUIRE(builtin_type_id(None()) == Id::Count);
+    REQUIRE(builtin_type_id(nullptr) == Id::Count);
+}
+
+TEST_CASE("SEMA_Type_Interning") {
+    StringBuffer reader("a = [1, 2]\n"
+                        "b = [3, 4]\n"
+                        "c = {1: [2, 3], 7: [8, 9]}\n"
+                        "d = {4: [5, 6], 0: [1, 2]}\n"
+                        "e = (1, 2.0)\n");
+    Lexer        lex(reader);
+    Parser       parser(lex);
+    Module*      mod = parser.parse_module();
+
+    SemanticAnalyser sema;
+    sema.exec(mod, 0);
+    REQUIRE(sema.errors.empty());
+
+    auto type = [&](const char* name) {
+        return sema.bindings.get_type(sema.bindings.get_varid(StringRef(name)));
+    };
+
+    // structurally equal containers share their instance
+    REQUIRE(type("a") == type("b"));
+    REQUIRE(type("c") == type("d"));
+    REQUIRE(str(type("c")) == "Dict[i32, Array[i32]]");
+    REQUIRE(str(type("a")) == "Array[i32]");
+
+    TypeInterner& types = sema.types;
+    REQUIRE(types.same(type("a"), type("b")));
+    REQUIRE(!types.same(type("a"), type("c")));
+    REQUIRE(types.id(type("e")) > 0);
+    REQUIRE(types.id(nullptr) == 0);
+
+    // names are compared by identifier, like equal()
+    Name* i32_a = sema.make_ref(mod, "i32");
+    Name* i32_b = sema.make_ref(mod, "i32");
+    REQUIRE(i32_a != i32_b);
+    REQUIRE(types.id(i32_a) == types.id(i32_b));
+    REQUIRE(types.id(i32_a) != types.id(sema.make_ref(mod, "f64")));
+
+    // a type built by hand is interned with the canonical one
+    ArrayType* array = mod->new_object<ArrayType>();
+    array->value     = i32_a;
+    REQUIRE(types.id(array) == types.id(type("a")));
+
+    // expressions that are not types fall back to equal()
+    REQUIRE(types.id(None()) == -1);
+    REQUIRE(types.same(None(), None()));
+
+    // arrows are interned like the containers
+    Array<TypeExpr*> args = {i32_a, type("a")};
+    Arrow*           call = types.arrow(mod, args, i32_b);
+    REQUIRE(types.canonical(call));
+    REQUIRE(call == types.arrow(mod, {sema.make_ref(mod, "i32"), array}, i32_a));
+    REQUIRE(call->args[0] == types.name(StringRef("i32")));
+
+    // the canonical types are shared by every module, they outlive them
+    std::size_t  count = types.size();
+    StringBuffer other_reader("x = [5, 6, 7]\n"
+                              "y = (3, 4.0)\n");
+    Lexer        other_lex(other_reader);
+    Parser       other_parser(other_lex);
+    Module*      other = other_parser.parse_module();
+
+    SemanticAnalyser other_sema;
+    other_sema.exec(other, 0);
+    REQUIRE(other_sema.errors.empty());
+
+    auto other_type = [&](const char* name) {
+        return other_sema.bindings.get_type(other_sema.bindings.get_varid(StringRef(name)));
+    };
+    REQUIRE(other_type("x") == type("a"));
+    REQUIRE(other_type("y") == type("e"));
+    REQUIRE(types.size() == count);
+
+    // and by every thread
+    Array<std::thread> threads;
+    Array<TypeExpr*>   found(4, nullptr);
+    for (std::size_t i = 0; i < found.size(); i++) {
+        threads.emplace_back([&, i]() {
+            Module     scratch;
+            ArrayType* local = scratch.new_object<ArrayType>();
+            local->value     = types.name(StringRef("f64"));
+            found[i]         = types.array(&scratch, types.tuple(&scratch, {local, local}));
+        });
+    }
+    for (std::thread& thread: threads) {
+        thread.join();
+    }
+    for (TypeExpr* type: found) {
+        REQUIRE(type == found[0]);
+    }
+
+    delete other;
+    delete mod;
+}
+
+TEST_CASE("SEMA_Type_Interning_Shadowing") {
+    StringBuffer reader("class Point:\n"
+                        "    def __init__(self, x: i32):\n"
+                        "        self.x = x\n");
+    Lexer          lex(reader);
+    Parser         parser(lex);
+    Unique<Module> mod(parser.parse_module());
+
+    SemanticAnalyser sema;
+    sema.exec(mod.get(), 0);
+    REQUIRE(sema.errors.empty());
+
+    TypeInterner& types = sema.types;
+    ClassDef*     point = cast<ClassDef>(mod->body[0]);
+    TypeExpr*     list  = types.array(mod.get(), sema.make_ref(mod.get(), "Point"));
+    Name*         value = cast<Name>(static_cast<ArrayType*>(list)->value);
+    REQUIRE(types.canonical(list));
+
+    // def f(Point: i32), the argument shadows the class
+    Scope scope(sema.bindings);
+    sema.bindings.add(StringRef("Point"), nullptr, sema.make_ref(mod.get(), "i32"));
+
+    // the canonical name still refers to the class
+    REQUIRE(sema.get_class(value, 0) == point);
+    REQUIRE(sema.resolve_variable(value) == (TypeExpr*)point);
+
+    // the reference to the argument is not interned
+    Name* local = sema.make_ref(mod.get(), "Point");
+    REQUIRE(local->dynamic);
+    REQUIRE(types.id(local) == -1);
+    REQUIRE(static_cast<ArrayType*>(types.array(mod.get(), local))->value == local);
+}
+
+TEST_CASE("SEMA_Parallel_Bodies") {
+    String code = "x = 1\n"
+                  "\n"
+                  "def add(a: i32, b: i32) -> i32:\n"
+                  "    return a + b + x\n"
+                  "\n"
+                  "def bad(a: i32) -> i32:\n"
+                  "    return a + undefined\n"
+                  "\n"
+                  "def gen(n: i32):\n"
+                  "    yield n\n"
+                  "\n"
+                  "def early() -> i32:\n"
+                  "    return later(1)\n"
+                  "\n"
+                  "def later(a: i32) -> i32:\n"
+                  "    c = add(a, 2)\n"
+                  "    return c\n"
+                  "\n"
+                  "def wrong() -> f64:\n"
+                  "    return add(1, 2)\n"
+                  "\n"
+                  "y = add(1, 2)\n"
+                  "z = missing\n";
+
+    // errors in order, the types of the functions and the bindings of the module
+    auto analyse = [&](ThreadPool* pool, bool arena = true) {
+        StringBuffer reader(code);
+        Lexer        lex(reader);
+        Parser       parser(lex);
+        Module*      mod = nullptr;
+
+        if (arena) {
+            mod = parser.parse_module();
+        } else {
+            mod = new Module();
+            parser.parse_to_module(mod);
+        }
+
+        SemanticAnalyser sema;
+        if (pool != nullptr) {
+            sema.exec_parallel(mod, *pool);
+        } else {
+            sema.exec(mod, 0);
+        }
+
+        Array<String> result;
+        for (auto& error: sema.errors) {
+            result.push_back(String(error->what()));
+        }
+        for (StmtNode* stmt: mod->body) {
+            if (FunctionDef* fun = cast<FunctionDef>(stmt)) {
+                result.push_back(fmtstr("{} {} {}", str(fun->name), str(fun->type), bool(fun->generator)));
+            }
+        }
+        for (BindingEntry const& entry: sema.bindings.bindings) {
+            result.push_back(fmtstr("{} {}", str(entry.name), entry.type ? str(entry.type) : "-"));
+        }
+
+        delete mod;
+        return result;
+    };
+
+    Array<String> serial = analyse(nullptr);
+    REQUIRE(serial.size() > 4);
+
+    // the result does not depend on the order the bodies are done in
+    ThreadPool pool(4);
+    for (int i = 0; i < 4; i++) {
+        REQUIRE(analyse(&pool) == serial);
+    }
+
+    // without an arena the module is analysed serially
+    REQUIRE(analyse(&pool, false) == serial);
+}
+
+TEST_CASE("SEMA_Parallel_Attributes") {
+    // the first function sets the type of x, the second one is checked against it
+    String code = "class P:\n"
+                  "    def __init__(self):\n"
+                  "        self.x = None\n"
+                  "\n"
+                  "def f(p: P):\n"
+                  "    p.x = 1\n"
+                  "\n"
+                  "def g(p: P):\n"
+                  "    p.x = 2.0\n";
+
+    auto analyse = [&](ThreadPool* pool) {
+        StringBuffer   reader(code);
+        Lexer          lex(reader);
+        Parser         parser(lex);
+        Unique<Module> mod(parser.parse_module());
+
+        SemanticAnalyser sema;
+        if (pool != nullptr) {
+            sema.exec_parallel(mod.get(), *pool);
+        } else {
+            sema.exec(mod.get(), 0);
+        }
+
+        Array<String> result;
+        for (auto& error: sema.errors) {
+            result.push_back(String(error->what()));
+        }
+
+        ClassDef* cls = cast<ClassDef>(mod->body[0]);
+        for (ClassDef::Attr const& attr: cls->attributes) {
+            result.push_back(fmtstr("{} {}", str(attr.name), attr.type ? str(attr.type) : "-"));
+        }
+        return result;
+    };
+
+    Array<String> serial = analyse(nullptr);
+    REQUIRE(serial.size() == 3);
+
+    ThreadPool pool(4);
+    for (int i = 0; i < 8; i++) {
+        REQUIRE(analyse(&pool) == serial);
+    }
+}
+
+TEST_CASE("SEMA_Lazy_Bodies") {
+    String code = "def f(a: i32) -> i32:\n"
+                  "    x = )\n"
+                  "    return a\n"
+                  "\n"
+                  "y = f(1)\n";
+
+    StringBuffer reader(code);
+    Lexer        lex(reader);
+    Parser       parser(lex);
+    parser.set_lazy_bodies(true);
+    Unique<Module> mod(parser.parse_module());
+    REQUIRE(parser.get_errors().empty());
+
+    // the syntax errors of the body are reported by sema
+    SemanticAnalyser sema;
+    sema.exec(mod.get(), 0);
+    REQUIRE(!sema.errors.empty());
+    REQUIRE(dynamic_cast<DeferredSyntaxError*>(sema.errors[0].get()) != nullptr);
+}
+
+TEST_CASE("SEMA_Import_Registry") {
+    namespace fs = std::filesystem;
+
+    fs::path dir = fs::temp_directory_path() / "lython_import_registry";
+    fs::create_directories(dir);
+
+    auto write = [&](const char* name, const char* code) {
+        std::ofstream out(dir / name);
+        out << code;
+    };
+
+    write("reg_a.py", "import reg_b\n\ndef fa(a: i32) -> i32:\n    return a\n");
+    write("reg_b.py", "import reg_a\n\ndef fb(a: i32) -> i32:\n    return a\n");
+    write("reg_c.py", "x = 1\n\ndef fc(a: i32) -> i32:\n    return a\n");
+
+    // binding added by the import, the assertions are not made here, it runs on the pool
+    auto import = [&](String const& code) {
+        StringBuffer   reader(code);
+        Lexer          lex(reader);
+        Parser         parser(lex);
+        Unique<Module> mod(parser.parse_module());
+
+        SemanticAnalyser sema;
+        sema.paths.push_back(String(dir.string().c_str()));
+        sema.exec(mod.get(), 0);
+        return sema.bindings.bindings.back();
+    };
+
+    ModuleRegistry& registry = ModuleRegistry::instance();
+    registry.clear();
+
+    // the module is parsed and analysed once
+    BindingEntry first  = import("from reg_c import fc\n");
+    BindingEntry second = import("from reg_c import fc\n");
+    REQUIRE(str(first.name) == "fc");
+    REQUIRE(first.value == second.value);
+    REQUIRE(first.type == second.type);
+    REQUIRE(registry.size() == 1);
+
+    // concurrent imports wait for the first one
+    BindingEntry module = import("import reg_c\n");
+    REQUIRE(str(module.name) == "reg_c");
+    {
+        ThreadPool                pool(4);
+        Array<std::future<Node*>> futures;
+
+        for (int i = 0; i < 8; i++) {
+            futures.push_back(pool.queue_task([&]() { return import("import reg_c\n").value; }));
+        }
+        for (auto& future: futures) {
+            REQUIRE(future.get() == module.value);
+        }
+    }
+    REQUIRE(registry.size() == 1);
+
+    // modules importing each other see each other partially initialised
+    BindingEntry circular = import("from reg_a import fa\n");
+    REQUIRE(str(circular.type) == "(i32) -> i32");
+    REQUIRE(registry.size() == 3);
+
+    // a module that changed is loaded again, the previous version stays valid
+    write("reg_c.py", "y = 2\n\ndef fc(a: i32) -> i32:\n    return y\n");
+    BindingEntry changed = import("from reg_c import fc\n");
+    REQUIRE(changed.value != first.value);
+    REQUIRE(str(first.type) == "(i32) -> i32");
+    REQUIRE(registry.size() == 4);
+
+    registry.clear();
+    fs::remove_all(dir);
+}
+
 TEST_CASE("SEMA_ClassDef_Attribute") {
     static Array<TestCase> ex = {
         {
@@ -1,5 +1,6 @@
 #include <catch2/catch.hpp>
 
+#include "utilities/arena.h"
 #include "utilities/strings.h"
 
 using namespace lython;
@@ -30,3 +31,38 @@ TEST_CASE("strings") {
         REQUIRE(split('.', "") == Array<String>{""});
     }
 }
+
+TEST_CASE("arena") {
+    struct Tracked {
+        Tracked(Array<int>& order, int id): order(order), id(id) {}
+        ~Tracked() { order.push_back(id); }
+
+        Array<int>& order;
+        int         id;
+    };
+
+    Array<int> order;
+    {
+        Arena arena(128);
+
+        for (int i = 0; i < 100; i++) {
+            Tracked* obj = arena.make<Tracked>(order, i);
+            REQUIRE(obj->id == i);
+            REQUIRE(reinterpret_cast<std::size_t>(obj) % alignof(Tracked) == 0);
+        }
+
+        // larger than a block
+        char* big = static_cast<char*>(arena.allocate(1024, 64));
+        REQUIRE(reinterpret_cast<std::size_t>(big) % 64 == 0);
+        big[1023] = 'a';
+
+        REQUIRE(arena.allocated() >= 100 * sizeof(Tracked) + 1024);
+        REQUIRE(order.empty());
+    }
+
+    // objects are destroyed in the reverse order of their creation
+    REQUIRE(order.size() == 100);
+    for (int i = 0; i < 100; i++) {
+        REQUIRE(order[i] == 99 - i);
+    }
+}